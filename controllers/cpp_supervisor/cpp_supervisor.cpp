@@ -7,6 +7,9 @@
 #include <filesystem>
 #include <unistd.h>   
 
+#include "checkpoint.hh"
+#include "world_rules.hh"
+
 using namespace webots;
 
 #define TIME_MAX 1200
@@ -21,6 +24,14 @@ int print_time_interval = 10;
 // Get the working directory path
 char *pPath = getenv("WB_WORKING_DIR");
 
+// Supervisor part of a checkpoint, see checkpoint.hh
+template <class Archive>
+void supervisorCheckpoint(Archive &ar, double &time, std::mt19937 &gen, bool &show_info) {
+  ar.field("time", time);
+  ar.field("gen", gen);
+  ar.field("show_info", show_info);
+}
+
 // Function to clean up and delete the Supervisor instance
 static int cleanUp(Supervisor *supervisor) {
   delete supervisor;
@@ -89,7 +100,8 @@ int main() {
   std::cout << "MAIN SUPERVISOR LOOP" << '\n';
   bool show_info = false;
   std::ofstream outputFile;
-  outputFile.open("data_rov.txt");
+  // In the Webots working directory, which run_webots.sh keeps per instance
+  outputFile.open(std::string(pPath != NULL ? pPath : ".") + "/data_rov.txt");
     // Check if the file was successfully opened
   if (!outputFile.is_open()) {
     std::cerr << "Error: Unable to open data_rov.txt for writing" << std::endl;
@@ -97,9 +109,22 @@ int main() {
   } else {
     std::cout << "File data_rov.txt opened successfully" << std::endl;
   }
+  // Continue a checkpointed run, or prepare to save one
+  double time_offset = 0;
+  const char *restoreDir = getenv("RUGBOT_RESTORE_DIR");
+  if (restoreDir != NULL) {
+    CheckpointReader reader(checkpointPath(restoreDir, "checkpoint_supervisor.txt"));
+    if (reader.load([&](CheckpointReader &ar) { supervisorCheckpoint(ar, time_offset, gen, show_info); })) {
+      std::cout << "Restored checkpoint at t=" << time_offset << '\n';
+    } else {
+      std::cerr << "Error: Unable to restore checkpoint from " << restoreDir << std::endl;
+    }
+  }
+  double saveAt = checkpointTime();
+
   // Main simulation loop
   while (supervisor->step(TIME_STEP) != -1) {
-    const double t = supervisor->getTime();
+    const double t = supervisor->getTime() + time_offset;
 
 
     // Print information at specified time intervals
@@ -127,7 +152,7 @@ int main() {
           if (rov != rov1) {
             const double *values_other = rov->getField("translation")->getSFVec3f();
             double dist = sqrt(pow(values_other[0] - values[0], 2) + pow(values_other[2] - values[2], 2));
-            if (dist < 0.03) {
+            if (dist < RELOCATE_DISTANCE) {
               const double RANDOM[3] = {dis(gen), 0.0125, dis(gen)};
               rov->getField("translation")->setSFVec3f(RANDOM);
               rov->resetPhysics();
@@ -139,6 +164,20 @@ int main() {
         show_info = true;
     }
 
+    // Save the world together with the controllers (same step, same time)
+    if (saveAt >= 0 && t >= saveAt) {
+      saveAt = -1;
+      const char *dir = getenv("RUGBOT_CHECKPOINT_DIR");
+      CheckpointWriter writer(checkpointPath(dir, "checkpoint_supervisor.txt"));
+      double time = t;
+      supervisorCheckpoint(writer, time, gen, show_info);
+      if (writer.good() && supervisor->worldSave(checkpointPath(dir, "checkpoint.wbt"))) {
+        std::cout << "Saved checkpoint world in " << dir << " at t=" << t << '\n';
+      } else {
+        std::cerr << "Error: Unable to save checkpoint in " << dir << std::endl;
+      }
+    }
+
 
   if(t>1200){
     // Pause simulation and exit
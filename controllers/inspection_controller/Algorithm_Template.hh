@@ -6,13 +6,21 @@
 #include <complex>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <utility>
 #include <filesystem>
 #include "filtering.hh"
+#include "spectral_estimator.hh"
 #include "RugBot.hh"
 
 #include "radio.hh"
 #include "controller_settings.hh"
+#include "profiling.hh"
+#include "alloc_guard.hh"
+#include "checkpoint.hh"
+#ifdef RUGBOT_BEHAVIOURS
+#include "behaviour.hh"
+#endif
 
 typedef std::complex<double> Complex;
 typedef std::vector<Complex> CArray;
@@ -37,10 +45,17 @@ public:
 
     // Time step for the simulation
     enum { TIME_STEP = 20 };
+    // Accelerometer samples per spectral block in STATE_OBS
+    enum { OBS_BLOCK = 64 };
 
-    Algorithm1() : settings(),robot(TIME_STEP),radio(robot.d_robot,TIME_STEP) {};
+    Algorithm1() : settings(),robot(TIME_STEP),radio(robot.d_robot,TIME_STEP),spectrum(OBS_BLOCK,1000.0/static_cast<double>(TIME_STEP),1.0,24.0) {};
 
     void run();
+    int step();
+    void control();
+    void startObservation();
+    bool observe();
+    void writePeaks();
     void recvSample();
     void sendSample(int sample);
 
@@ -49,7 +64,26 @@ private:
     RugRobot robot;
 
     Radio_Rover radio;
-    std::vector<int> pos;
+#ifdef RUGBOT_BEHAVIOURS
+    BehaviourScheduler behaviours{robot};
+#endif
+    SpectralEstimator spectrum;
+    // Vibration peaks not yet written to peaks_path, see writePeaks()
+    Array peak_freqs;
+    Array peak_mags;
+    std::string peaks_path;
+    long dropped_peaks = 0;
+    GridCell pos;
+    std::vector<int> messages;
+    long stepCount = 0;
+    // Simulated time of the checkpoint to save, -1 for none
+    double saveAt = -1;
+
+    void updateCustomData();
+
+    template <class Archive> void checkpoint(Archive &ar);
+    void saveCheckpoint();
+    void restoreCheckpoint(const char *dir);
 
 
 };
@@ -59,38 +93,178 @@ void Algorithm1::run() {
     pos = roundToNearest10(robot.getPos());
     robot.setCustomData("");
     settings.readSettings();
+    messages.reserve(64);
+    peak_freqs.reserve(1024);
+    peak_mags.reserve(1024);
+    peaks_path = std::string(pPath != NULL ? pPath : ".") + "/freq_mag_output_" + robot.name + ".txt";
+
+    const char *restoreDir = getenv("RUGBOT_RESTORE_DIR");
+    if (restoreDir != NULL) {
+        restoreCheckpoint(restoreDir);
+    }
+    saveAt = checkpointTime();
+
+    while(step() != -1) {
+        control();
+        writePeaks();
+        if (saveAt >= 0 && robot.getTime() >= saveAt) {
+            saveCheckpoint();
+            saveAt = -1;
+        }
+    }
+    if (dropped_peaks > 0) {
+        std::cerr << robot.name << ": dropped " << dropped_peaks << " vibration peaks" << std::endl;
+    }
+    PROF_REPORT(robot.d_robot->getName(), robot.d_robot->getTime());
+}
 
-    while(robot.d_robot->step(TIME_STEP) != -1) {
-        
-        switch(states) {
+void Algorithm1::control() {
+    PROF_SCOPE(control_latency);
+    ALLOC_GUARD(stepCount);
+
+    switch(states) {
+
+        case STATE_RW:
+#ifdef RUGBOT_BEHAVIOURS
+            if (!behaviours.running()) {
+                behaviours.start(randomWalk(behaviours));
+            }
+            if (behaviours.tick(TIME_STEP)) {
+                states = STATE_OBS;
+                startObservation();
+            }
+            PROF_STATE(robot_states, robot.state, robot.lastDuration);
+#else
+            if(robot.RandomWalk()==1){
+                states = STATE_OBS;
+                startObservation();
+            }
+#endif
+            break;
+
+        case STATE_OBS:
+            if (observe()) {
+                states = STATE_RW;
+            }
+            break;
+
+
+        case STATE_PAUSE:
+            // Pause logic here
+            break;
+    }
+    if(robot.getTime()>5){
+        updateCustomData();
+    }
+    PROF_STATE(algo_states, states, robot.lastDuration);
+}
 
-            case STATE_RW:
+// Advances several time steps at once while the random walk only drives
+// forward (RugRobot::sleepSteps), but never past the checkpoint time.
+int Algorithm1::step() {
+    PROF_SCOPE(step_latency);
+    ++stepCount;
+    int steps = 1;
+#ifndef RUGBOT_BEHAVIOURS
+    if (states == STATE_RW) {
+        steps = robot.sleepSteps();
+    }
+#endif
+    if (saveAt >= 0) {
+        steps = std::clamp((int) ((saveAt - robot.getTime()) * 1000.0 / static_cast<double>(TIME_STEP)), 1, steps);
+    }
+    return robot.step(steps * TIME_STEP);
+}
 
-                if(robot.RandomWalk()==1){
-                    states = STATE_OBS;
-                }
+// Stand still on the cell and start a new vibration estimate
+void Algorithm1::startObservation() {
+    robot.setSpeed(0, 0);
+    spectrum.reset();
+}
 
-                break;
+// Feeds the vertical acceleration to the spectral estimator. The dwell ends
+// after the first block at which the peak is clear, or at the longest dwell
+// for ambiguous cells; returns true when the observation is complete.
+bool Algorithm1::observe() {
+    if (!spectrum.addSample(robot.accelerometer->getValues()[2]) || !spectrum.done()) {
+        return false;
+    }
+    // Within the reserved capacity, so no allocation in the control step
+    if (peak_freqs.size() < peak_freqs.capacity()) {
+        peak_freqs.push_back(spectrum.peakFrequency());
+        peak_mags.push_back(spectrum.peakMagnitude());
+    } else {
+        ++dropped_peaks;
+    }
+    return true;
+}
 
-            case STATE_OBS:
-                states = STATE_RW;                  
-                break;
+// Appends the new peaks to this robot's freq_mag_output_<name>.txt in
+// WB_WORKING_DIR after the step that observed them, outside control(), so a
+// run that is killed keeps what it measured.
+void Algorithm1::writePeaks() {
+    if (peak_freqs.empty()) {
+        return;
+    }
+    appendValuesToFile(peaks_path, peak_freqs, peak_mags);
+    peak_freqs.clear();
+    peak_mags.clear();
+}
 
+// customData = "<whole seconds>,<robot number>", formatted without heap use.
+// The robot number is the whole name after the leading 'r'.
+void Algorithm1::updateCustomData() {
+    char buffer[64];
+    int size = snprintf(buffer, sizeof(buffer), "%d,%s", (int) robot.getTime(), robot.name.c_str() + 1);
+    robot.setCustomData(buffer, std::min((std::size_t) size, sizeof(buffer) - 1));
+}
 
-            case STATE_PAUSE:
-                // Pause logic here
-                break;
-        }
-        if(robot.d_robot->getTime()>5){
-        robot.setCustomData( std::to_string((int) robot.d_robot->getTime())+
-        ","+std::string(robot.d_robot->getName().substr(1,1)) );
-        }
+template <class Archive>
+void Algorithm1::checkpoint(Archive &ar) {
+    double time = robot.getTime();
+    ar.field("time", time);
+    ar.field("algo_state", states);
+    ar.field("pos_x", pos.x);
+    ar.field("pos_y", pos.y);
+    ar.field("stepCount", stepCount);
+    robot.checkpoint(ar);
+    radio.checkpoint(ar);
+    spectrum.checkpoint(ar);
+    ar.field("peak_freqs", peak_freqs);
+    ar.field("peak_mags", peak_mags);
+    if (ar.restoring()) {
+        robot.time_offset = time;
+    }
+}
+
+void Algorithm1::saveCheckpoint() {
+    std::string path = checkpointPath(getenv("RUGBOT_CHECKPOINT_DIR"), "checkpoint_" + robot.name + ".txt");
+    CheckpointWriter writer(path);
+    checkpoint(writer);
+#ifdef RUGBOT_BEHAVIOURS
+    std::cout << "The running behaviour is not part of the checkpoint and restarts on restore" << '\n';
+#endif
+    if (writer.good()) {
+        std::cout << "Saved checkpoint " << path << " at t=" << robot.getTime() << '\n';
+    } else {
+        std::cerr << "Unable to write checkpoint " << path << '\n';
+    }
+}
+
+void Algorithm1::restoreCheckpoint(const char *dir) {
+    std::string path = checkpointPath(dir, "checkpoint_" + robot.name + ".txt");
+    CheckpointReader reader(path);
+    if (reader.load([this](CheckpointReader &ar) { checkpoint(ar); })) {
+        std::cout << "Restored checkpoint " << path << " at t=" << robot.getTime() << '\n';
+    } else {
+        std::cerr << "Unable to restore checkpoint " << path << " (field " << reader.error()
+                  << "), starting from the initial state" << '\n';
     }
 }
 
 
 void Algorithm1::recvSample(){
-    std::vector<int> messages = radio.getMessages();
+    radio.getMessages(messages);
         // Process received messages
         for (int sample : messages) {
             //Do something
@@ -100,11 +274,8 @@ void Algorithm1::recvSample(){
 void Algorithm1::sendSample(int sample){
 
     // Determine the message to send based on decision flag or observation color
-    int const *message;
-
-    message = &sample;
-    // Send the message
-    radio.sendMessage(message, sizeof(message));
+    // Send the message; the size is in bytes
+    radio.sendMessage(&sample, sizeof(sample));
 
 }
 
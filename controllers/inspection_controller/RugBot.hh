@@ -10,12 +10,31 @@
 #include <webots/Receiver.hpp>
 #include <webots/Motor.hpp>
 #include <webots/Gyro.hpp>
+#include <webots/Accelerometer.hpp>
 #include <random>
 #include <cmath>
 #include <string>  
 
+#include "filtering.hh"
+#include "profiling.hh"
+#include "trace.hh"
+#include "world_rules.hh"
+
 using namespace webots;
 
+// Position of the robot on the floor grid, in cm.
+struct GridCell {
+    int x;
+    int y;
+};
+
+inline bool operator==(const GridCell &a, const GridCell &b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(const GridCell &a, const GridCell &b) { return !(a == b); }
+
+inline GridCell roundToNearest10(const GridCell &cell) {
+    return GridCell{roundToNearest10(cell.x), roundToNearest10(cell.y)};
+}
+
 
 
 class RugRobot {
@@ -25,17 +44,38 @@ public:
     Motor *leftMotor;
     Motor *rightMotor;
     Gyro *gyro;
+    Accelerometer *accelerometer;
     Node *d_this_robot_node;
     Field *translationData;
     Field *customData;
+    // Translation fields of the other robots r0, r1, ... of the world
+    std::vector<Field*> otherRobots;
     Emitter *emitter;
     Receiver *receiver;
+    TraceWriter *trace = nullptr;
+
+    std::string name;
+    // Last value written to the customData field, see setCustomData();
+    // the first call always writes, whatever the world file contains
+    std::string lastCustomData;
+    bool customDataWritten = false;
 
     double timeStep;
     double rw_time;
     double rw_angle;
     double ca_angle;
-    double spend_time;
+    double spend_time = 0;
+    // Simulated time at which this run was restored from a checkpoint
+    double time_offset = 0;
+    // Duration of the last step() and the current sensor sampling period, ms
+    int lastDuration;
+    int samplingPeriod;
+    // Most time steps one step() may cover in STATE_FW, see sleepSteps()
+    int max_sleep_steps = 10;
+    double wheel_radius = 0.0055;
+    // Wheel speed at setSpeed(100), rad/s, and the distance sensor range, mm
+    double max_wheel_speed = 10.0;
+    double sensor_range = 150.0;
 
     double CA_Threshold = 60.0;
     std::size_t static const n_sensors = 3;
@@ -84,20 +124,29 @@ public:
 
     RugRobot(double timeStep);
     ~RugRobot();
+    int step(int duration);
+    int sleepSteps() const;
+    double nearestRobot() const;
+    void setSamplingPeriod(int period);
+    void recordInputs(int duration);
     void setSpeed(double speedl, double speedr);
     int turnAngle(double Angle);
     void clearAngle();
     void sendMessage(const int *data, int size);
-    std::vector<int> getMessages();
+    void getMessages(std::vector<int> &messages);
     bool collAvoid();
     int RandomWalk();
     void generateRW();
     void setCustomData(const std::string& inputString);
-    std::vector<int> getPos();
+    void setCustomData(const char *data, std::size_t size);
+    GridCell getPos();
+    double getTime() const { return d_robot->getTime() + time_offset; }
+
+    template <class Archive> void checkpoint(Archive &ar);
 
 };
 
-RugRobot::RugRobot(double timeStep) : timeStep(timeStep) {
+RugRobot::RugRobot(double timeStep) : timeStep(timeStep), lastDuration((int) timeStep), samplingPeriod((int) timeStep) {
     d_robot = new Supervisor();
 
 
@@ -117,13 +166,29 @@ RugRobot::RugRobot(double timeStep) : timeStep(timeStep) {
 
     d_this_robot_node = d_robot->getSelf();
     translationData = d_this_robot_node->getField("translation");
+    translationData->enableSFTracking(timeStep);
     customData = d_this_robot_node->getField("customData");
 
 
     gyro = d_robot->getGyro("gyro");
     gyro->enable(timeStep); 
-
-    std::string name = d_robot->getName();
+    accelerometer = d_robot->getAccelerometer("accelerometer");
+    accelerometer->enable(timeStep);
+
+    name = d_robot->getName();
+    lastCustomData.reserve(64);
+    // Found as cpp_supervisor finds them: DEF r0, r1, ... up to the first gap
+    for (int i = 0;; ++i) {
+        Node *node = d_robot->getFromDef("r" + std::to_string(i));
+        if (node == NULL) {
+            break;
+        }
+        if (node != d_this_robot_node) {
+            otherRobots.push_back(node->getField("translation"));
+            // Streamed with every step instead of one request per read
+            otherRobots.back()->enableSFTracking(timeStep);
+        }
+    }
     int SeedRov = ((int) name[1]) * 10;
     srand(SeedRov);
     std::cout << "RugRobot " << name[1] << " with Seed " << SeedRov << '\n';
@@ -144,20 +209,150 @@ RugRobot::RugRobot(double timeStep) : timeStep(timeStep) {
     //std::cout << "Motor deviations[a,s]:" << motor_dev << ',' << speed_dev << '\n';
 
     generateRW();
-    
 
+    // RUGBOT_MAX_SLEEP_STEPS=1 steps every time step, e.g. to replay traces
+    // recorded without multi-step sleeping
+    const char *maxSleep = getenv("RUGBOT_MAX_SLEEP_STEPS");
+    if (maxSleep != NULL) {
+        max_sleep_steps = std::max(1, atoi(maxSleep));
+    }
     
+    // Record a sensor trace for offline replay when RUGBOT_TRACE is set
+    const char *traceDir = getenv("RUGBOT_TRACE");
+    if (traceDir != NULL) {
+        TraceHeader header;
+        header.time_step = (uint32_t) timeStep;
+        header.name = name;
+        for (std::size_t i = 0; i < n_sensors; ++i) {
+            header.sensor_names.push_back(distance_sensors_names[i]);
+        }
+        const double *pose = translationData->getSFVec3f();
+        std::copy(pose, pose + 3, header.initial_pose);
+        header.initial_nearest = nearestRobot();
+
+        std::string path = std::string(traceDir) + "/trace_" + name + ".bin";
+        trace = new TraceWriter(path, header);
+        if (trace->isOpen()) {
+            activeTrace = trace;
+            std::cout << "Recording trace to " << path << '\n';
+        } else {
+            std::cerr << "Unable to open trace file " << path << '\n';
+            delete trace;
+            trace = nullptr;
+        }
+    }
 }
 
 
 
 RugRobot::~RugRobot() {
+    if (trace != nullptr) {
+        trace->endFrame(leftMotor->getVelocity(), rightMotor->getVelocity());
+        activeTrace = nullptr;
+        delete trace;
+    }
     delete d_robot;
 }
 
+// Advance the simulation, recording the step when a trace is active. The
+// sensors are sampled once per call, also when it covers several time steps.
+int RugRobot::step(int duration) {
+    if (trace != nullptr) {
+        trace->endFrame(leftMotor->getVelocity(), rightMotor->getVelocity());
+    }
+    if (duration != samplingPeriod) {
+        setSamplingPeriod(duration);
+    }
+    lastDuration = duration;
+    int result = d_robot->step(duration);
+    if (trace != nullptr && result != -1) {
+        recordInputs(duration);
+    }
+    return result;
+}
+
+void RugRobot::setSamplingPeriod(int period) {
+    for (std::size_t i = 0; i < n_sensors; ++i) {
+        d_distance_sensors[i]->enable(period);
+    }
+    gyro->enable(period);
+    accelerometer->enable(period);
+    samplingPeriod = period;
+}
+
+// Number of time steps the next step() can cover without RandomWalk()
+// missing a state change: only in STATE_FW, never past rw_time, and only
+// while every distance sensor reads out of range. An obstacle along a ray
+// then needs (sensor_range - CA_Threshold) / closing steps to reach
+// CA_Threshold, taking it to close in at this robot's speed plus that of a
+// robot driving at max_wheel_speed. Small obstacles or corners passing
+// between the rays can still show up later than without sleeping, as they
+// can between two normal steps. Under the same closing speed no other robot
+// may come within RELOCATE_DISTANCE, or the supervisor could move this
+// robot mid-sleep.
+int RugRobot::sleepSteps() const {
+    if (state != STATE_FW || max_sleep_steps <= 1) {
+        return 1;
+    }
+    for (std::size_t i = 0; i < n_sensors; ++i) {
+        if (d_distance_sensors[i]->getValue() < sensor_range) {
+            return 1;
+        }
+    }
+    // RandomWalk() turns at the first step that ends with spend_time > rw_time
+    double steps = std::floor((rw_time - spend_time) / timeStep) + 1;
+
+    // Sensor values are in mm, wheel speeds in rad/s
+    double speed = std::max(std::abs(leftMotor->getVelocity()), std::abs(rightMotor->getVelocity()));
+    double closing = (speed + max_wheel_speed) * wheel_radius * timeStep;
+    steps = std::min(steps, std::floor((sensor_range - CA_Threshold) / closing) + 1);
+    steps = std::clamp(steps, 1.0, (double) max_sleep_steps);
+    if (steps > 1 && nearestRobot() - closing / 1000 * steps < RELOCATE_DISTANCE) {
+        return 1;
+    }
+    return (int) steps;
+}
+
+// Centre distance in the x-z plane to the nearest other robot, as measured
+// by cpp_supervisor
+double RugRobot::nearestRobot() const {
+    const double *own = translationData->getSFVec3f();
+    double nearest = INFINITY;
+    for (Field *other : otherRobots) {
+        const double *position = other->getSFVec3f();
+        nearest = std::min(nearest, std::hypot(position[0] - own[0], position[2] - own[2]));
+    }
+    return nearest;
+}
+
+void RugRobot::recordInputs(int duration) {
+    TraceFrame &frame = trace->frame;
+    frame.duration = (uint32_t) duration;
+    frame.time = d_robot->getTime();
+    for (std::size_t i = 0; i < n_sensors; ++i) {
+        frame.distance[i] = d_distance_sensors[i]->getValue();
+    }
+    std::copy(gyro->getValues(), gyro->getValues() + 3, frame.gyro);
+    std::copy(accelerometer->getValues(), accelerometer->getValues() + 3, frame.accel);
+    std::copy(translationData->getSFVec3f(), translationData->getSFVec3f() + 3, frame.pose);
+    frame.nearest = nearestRobot();
+    trace->pending = true;
+}
+
 
 void RugRobot::setCustomData(const std::string& inputString){
-    customData->setSFString(inputString);
+    setCustomData(inputString.data(), inputString.size());
+}
+
+// Only writes the field when its content changes; reuses the reserved
+// lastCustomData buffer so an unchanged or short value never allocates.
+void RugRobot::setCustomData(const char *data, std::size_t size){
+    if (customDataWritten && lastCustomData.size() == size && lastCustomData.compare(0, size, data, size) == 0) {
+        return;
+    }
+    customDataWritten = true;
+    lastCustomData.assign(data, size);
+    customData->setSFString(lastCustomData);
 }
 
 
@@ -207,8 +402,9 @@ void RugRobot::sendMessage(const int *data, int size) {
     emitter->send(data, size * sizeof(int));
 }
 
-std::vector<int> RugRobot::getMessages() {
-    std::vector<int> messages;
+// Fills messages with all queued packets; keeps its capacity between steps.
+void RugRobot::getMessages(std::vector<int> &messages) {
+    messages.clear();
 
     while (receiver->getQueueLength() > 0) {
         const int *data = (const int*)receiver->getData();
@@ -220,8 +416,6 @@ std::vector<int> RugRobot::getMessages() {
 
         receiver->nextPacket();
     }
-
-    return messages;
 }
 
 void RugRobot::generateRW(){
@@ -234,9 +428,10 @@ void RugRobot::generateRW(){
 }   
 
 int RugRobot::RandomWalk(){
+    PROF_SCOPE(random_walk_latency);
 
     if (spend_time == (double) timeStep){state= STATE_FW;}
-    spend_time+= (double) timeStep;
+    spend_time+= (double) lastDuration;
 
 
 
@@ -266,6 +461,7 @@ int RugRobot::RandomWalk(){
             //std::cout <<"TURN state exit"<<'\n';
             state = STATE_RESET;
         }}
+    PROF_STATE(robot_states, state, lastDuration);
     if (state == STATE_RESET){
         spend_time = 0;
         generateRW();
@@ -275,16 +471,43 @@ int RugRobot::RandomWalk(){
 
     }
 
-std::vector<int>RugRobot::getPos() {
-    std::vector<int> pos;
+// Everything that evolves during a run: state machine, random walk and PI
+// controller state, the random generator and the commanded motor speeds.
+template <class Archive>
+void RugRobot::checkpoint(Archive &ar) {
+    ar.field("robot_state", state);
+    ar.field("rw_time", rw_time);
+    ar.field("rw_angle", rw_angle);
+    ar.field("ca_angle", ca_angle);
+    ar.field("spend_time", spend_time);
+    ar.field("refAngle", refAngle);
+    ar.field("angleIntegrator", angleIntegrator);
+    ar.field("speed_dev", speed_dev);
+    ar.field("motor_dev", motor_dev);
+    ar.field("generator", generator);
+    ar.field("angle_dist", angle_dist);
+    ar.field("speed_dist", speed_dist);
+    ar.field("rw_time_gen", rw_time_gen);
+    ar.field("rw_angle_gen", rw_angle_gen);
+    ar.field("ca_angle_gen", ca_angle_gen);
+
+    double left = leftMotor->getVelocity();
+    double right = rightMotor->getVelocity();
+    ar.field("motor_left", left);
+    ar.field("motor_right", right);
+    if (ar.restoring()) {
+        leftMotor->setVelocity(left);
+        rightMotor->setVelocity(right);
+    }
+}
+
+GridCell RugRobot::getPos() {
     const double *coordinates = translationData->getSFVec3f();
     const double xPos = coordinates[0];
     const double yPos = coordinates[2];
 
-    pos.push_back((int) (xPos*100));
-    pos.push_back((int) (yPos*100));
-    //std::cout<<pos[0]<<","<<pos[1]<<'\n';
-    return pos;
+    //std::cout<<xPos<<","<<yPos<<'\n';
+    return GridCell{(int) (xPos*100), (int) (yPos*100)};
 }
 
 
@@ -0,0 +1,68 @@
+#ifndef INCLUDED_ALLOC_GUARD_HH_
+#define INCLUDED_ALLOC_GUARD_HH_
+
+// Test-mode heap guard for the controller step loop.
+//
+// Build with -DRUGBOT_ALLOC_GUARD (see the Makefile, or tools/trace_replay to
+// check a recorded run offline). After the first ALLOC_GUARD_WARMUP guarded
+// steps of the process, the control work between two step() calls must not
+// touch the heap; the first step that does aborts the controller with its
+// step number. The warmup counts from the process start, not from the step
+// number, so a run restored from a checkpoint warms up as well. Without the
+// flag ALLOC_GUARD() expands to nothing.
+//
+// The guard replaces the global operator new and delete, so this header may
+// only be included from the controller's single translation unit.
+
+#ifdef RUGBOT_ALLOC_GUARD
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+const long ALLOC_GUARD_WARMUP = 10;
+
+inline unsigned long long allocGuardCount = 0;
+// Guarded steps since the process started
+inline long allocGuardSteps = 0;
+
+void *operator new(std::size_t size) {
+    ++allocGuardCount;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+class AllocGuard {
+public:
+    explicit AllocGuard(long step) : step(step), warm(++allocGuardSteps > ALLOC_GUARD_WARMUP),
+                                     start(allocGuardCount) {}
+    ~AllocGuard();
+
+private:
+    long step;
+    bool warm;
+    unsigned long long start;
+};
+
+inline AllocGuard::~AllocGuard() {
+    unsigned long long n = allocGuardCount - start;
+    if (warm && n != 0) {
+        fprintf(stderr, "ALLOC GUARD: step %ld made %llu heap allocation(s)\n", step, n);
+        std::abort();
+    }
+}
+
+#define ALLOC_GUARD(step) AllocGuard alloc_guard_(step)
+
+#else
+
+#define ALLOC_GUARD(step)
+
+#endif // RUGBOT_ALLOC_GUARD
+
+#endif // INCLUDED_ALLOC_GUARD_HH_
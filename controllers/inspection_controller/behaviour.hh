@@ -0,0 +1,332 @@
+#ifndef INCLUDED_BEHAVIOUR_HH_
+#define INCLUDED_BEHAVIOUR_HH_
+
+#include <coroutine>
+#include <cstddef>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "RugBot.hh"
+#include "radio.hh"
+
+// Coroutine behaviours for RugRobot (C++20, enabled with -DRUGBOT_BEHAVIOURS).
+//
+// A behaviour is written as straight-line code instead of a state machine:
+//
+//   Behaviour inspect(BehaviourScheduler &s) {
+//       co_await s.forward_for(2000);
+//       co_await s.turn(90);
+//       if (co_await s.until(Collision{s.robot}, 5000)) ...
+//   }
+//
+// The scheduler is ticked once per control step and resumes the suspended
+// behaviour when its wait is over. A timer wait costs one comparison per
+// step; turn(), until() and message() poll their condition once per step.
+// Coroutine frames come from a fixed arena in the scheduler, so running a
+// behaviour never touches the heap. Suspended frames cannot be written to a
+// checkpoint; a restored run starts the behaviour again.
+
+class BehaviourScheduler;
+
+// Bump allocator for coroutine frames. Nested behaviours finish before their
+// caller, so frames are released in LIFO order and popping the top suffices;
+// anything else is reclaimed once the arena is empty.
+class BehaviourArena {
+public:
+    static const std::size_t SIZE = 8192;
+
+    void *allocate(std::size_t size) noexcept;
+    static void release(void *p) noexcept;
+    std::size_t used() const { return top; }
+
+private:
+    struct alignas(std::max_align_t) Header {
+        BehaviourArena *arena;
+        std::size_t offset;
+        std::size_t end;
+    };
+
+    alignas(std::max_align_t) unsigned char buffer[SIZE];
+    std::size_t top = 0;
+    std::size_t live = 0;
+};
+
+inline void *BehaviourArena::allocate(std::size_t size) noexcept {
+    const std::size_t align = alignof(std::max_align_t);
+    std::size_t total = (sizeof(Header) + size + align - 1) / align * align;
+    if (top + total > SIZE) {
+        return nullptr;
+    }
+    Header *header = new (buffer + top) Header{this, top, top + total};
+    top += total;
+    ++live;
+    return header + 1;
+}
+
+inline void BehaviourArena::release(void *p) noexcept {
+    Header *header = static_cast<Header*>(p) - 1;
+    BehaviourArena *arena = header->arena;
+    --arena->live;
+    if (arena->live == 0) {
+        arena->top = 0;
+    } else if (header->end == arena->top) {
+        arena->top = header->offset;
+    }
+}
+
+
+// Handle to a running behaviour; co_await it to run a nested behaviour.
+class Behaviour {
+public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    // Resumes the awaiting behaviour, if any, when this one finishes
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+
+        // The first parameter of every behaviour is its scheduler
+        template <class... Args>
+        static void *operator new(std::size_t size, BehaviourScheduler &s, Args &...) noexcept;
+        static void operator delete(void *p, std::size_t) noexcept { BehaviourArena::release(p); }
+        static Behaviour get_return_object_on_allocation_failure() { return Behaviour(); }
+
+        Behaviour get_return_object() { return Behaviour(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Behaviour() = default;
+    explicit Behaviour(Handle h) : h(h) {}
+    Behaviour(Behaviour &&other) noexcept : h(std::exchange(other.h, {})) {}
+    Behaviour &operator=(Behaviour &&other) noexcept {
+        if (this != &other) {
+            reset();
+            h = std::exchange(other.h, {});
+        }
+        return *this;
+    }
+    Behaviour(const Behaviour &) = delete;
+    Behaviour &operator=(const Behaviour &) = delete;
+    ~Behaviour() { reset(); }
+
+    bool valid() const { return (bool) h; }
+    bool done() const { return h && h.done(); }
+    Handle handle() const { return h; }
+    void reset() {
+        if (h) {
+            h.destroy();
+            h = {};
+        }
+    }
+
+    // Awaiting a nested behaviour transfers control to it directly
+    bool await_ready() const noexcept { return !h || h.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        h.promise().continuation = caller;
+        return h;
+    }
+    void await_resume() const noexcept {}
+
+private:
+    Handle h;
+};
+
+
+// A condition a suspended behaviour waits for, polled once per step
+struct Waiter {
+    virtual bool poll() = 0;
+};
+
+class BehaviourScheduler {
+public:
+    RugRobot &robot;
+    BehaviourArena arena;
+
+    explicit BehaviourScheduler(RugRobot &robot) : robot(robot) {}
+
+    // Runs b from the next tick on; the scheduler owns it from now
+    void start(Behaviour b);
+    // Advance the behaviour clock by elapsed ms and resume the behaviour
+    // when its wait is over. Returns true once when the behaviour finished.
+    bool tick(int elapsed);
+    bool running() const { return root.valid(); }
+    void stop();
+    double now() const { return now_ms; }
+
+    // Called by the awaiters below
+    void suspend(std::coroutine_handle<> h, double wake, Waiter *waiter) {
+        resume_point = h;
+        wake_ms = wake;
+        waiting = waiter;
+    }
+
+    struct TimerAwaiter {
+        BehaviourScheduler &s;
+        double ms;
+        bool await_ready() const noexcept { return ms <= 0; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { s.suspend(h, s.now_ms + ms, nullptr); }
+        void await_resume() const noexcept {}
+    };
+
+    struct TurnAwaiter : Waiter {
+        BehaviourScheduler &s;
+        double angle;
+        TurnAwaiter(BehaviourScheduler &s, double angle) : s(s), angle(angle) {}
+        bool poll() override { return s.robot.turnAngle(angle) == 1; }
+        bool await_ready() { return poll(); }
+        void await_suspend(std::coroutine_handle<> h) noexcept { s.suspend(h, s.now_ms, this); }
+        void await_resume() const noexcept {}
+    };
+
+    // Resumes with true when pred() holds, false once more than the timeout
+    // has passed. Both are first checked on the next step.
+    template <class Pred>
+    struct UntilAwaiter : Waiter {
+        BehaviourScheduler &s;
+        Pred pred;
+        double deadline;
+        bool fired = false;
+        UntilAwaiter(BehaviourScheduler &s, Pred pred, double deadline) : s(s), pred(std::move(pred)), deadline(deadline) {}
+        bool poll() override {
+            if (s.now_ms > deadline) {
+                return true;
+            }
+            fired = pred();
+            return fired;
+        }
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { s.suspend(h, s.now_ms, this); }
+        bool await_resume() const noexcept { return fired; }
+    };
+
+    struct MessageAwaiter : Waiter {
+        BehaviourScheduler &s;
+        Radio_Rover &radio;
+        std::vector<int> &messages;
+        MessageAwaiter(BehaviourScheduler &s, Radio_Rover &radio, std::vector<int> &messages)
+            : s(s), radio(radio), messages(messages) {}
+        bool poll() override {
+            radio.getMessages(messages);
+            return !messages.empty();
+        }
+        bool await_ready() { return poll(); }
+        void await_suspend(std::coroutine_handle<> h) noexcept { s.suspend(h, s.now_ms, this); }
+        void await_resume() const noexcept {}
+    };
+
+    TimerAwaiter sleep_for(double ms) { return TimerAwaiter{*this, ms}; }
+    TimerAwaiter forward_for(double ms) {
+        robot.setSpeed(100, 100);
+        return TimerAwaiter{*this, ms};
+    }
+    TurnAwaiter turn(double angle) { return TurnAwaiter(*this, angle); }
+    template <class Pred>
+    UntilAwaiter<Pred> until(Pred pred, double timeout_ms = INFINITY) {
+        return UntilAwaiter<Pred>(*this, std::move(pred), now_ms + timeout_ms);
+    }
+    // Waits for radio packets and leaves them in messages
+    MessageAwaiter message(Radio_Rover &radio, std::vector<int> &messages) {
+        return MessageAwaiter(*this, radio, messages);
+    }
+
+private:
+    Behaviour root;
+    std::coroutine_handle<> resume_point;
+    Waiter *waiting = nullptr;
+    double now_ms = 0;
+    double wake_ms = 0;
+};
+
+template <class... Args>
+void *Behaviour::promise_type::operator new(std::size_t size, BehaviourScheduler &s, Args &...) noexcept {
+    return s.arena.allocate(size);
+}
+
+inline void BehaviourScheduler::start(Behaviour b) {
+    stop();
+    if (!b.valid()) {
+        std::cerr << "Behaviour arena of " << robot.name << " is full (" << arena.used() << " bytes used)" << '\n';
+        return;
+    }
+    root = std::move(b);
+    suspend(root.handle(), now_ms, nullptr);
+}
+
+inline bool BehaviourScheduler::tick(int elapsed) {
+    now_ms += elapsed;
+    if (!resume_point || now_ms < wake_ms) {
+        return false;
+    }
+    if (waiting != nullptr && !waiting->poll()) {
+        return false;
+    }
+    std::coroutine_handle<> h = std::exchange(resume_point, {});
+    waiting = nullptr;
+    h.resume();
+    if (root.done()) {
+        root.reset();
+        return true;
+    }
+    return false;
+}
+
+inline void BehaviourScheduler::stop() {
+    root.reset();
+    resume_point = {};
+    waiting = nullptr;
+}
+
+
+// Predicate for until(): an obstacle is closer than CA_Threshold
+struct Collision {
+    RugRobot &robot;
+    bool operator()() const { return robot.collAvoid(); }
+};
+
+// One walk of RugRobot::RandomWalk() as a behaviour: pause a step, drive
+// forward for rw_time while turning away from obstacles, then turn by
+// rw_angle and draw the next walk.
+inline Behaviour randomWalk(BehaviourScheduler &s) {
+    RugRobot &robot = s.robot;
+    // rw_time counts from before the pause step, as spend_time does
+    const double deadline = s.now() - robot.timeStep + robot.rw_time;
+    robot.state = RugRobot::STATE_PAUSE;
+    co_await s.sleep_for(robot.timeStep);
+
+    bool collision = robot.collAvoid();
+    while (true) {
+        if (!collision) {
+            robot.state = RugRobot::STATE_FW;
+            robot.setSpeed(100, 100);
+            collision = co_await s.until(Collision{robot}, deadline - s.now());
+            if (!collision) {
+                break;
+            }
+        }
+        robot.state = RugRobot::STATE_CA;
+        co_await s.turn(robot.ca_angle);
+        robot.ca_angle = robot.ca_angle_gen(robot.generator);
+        collision = false;
+    }
+    robot.state = RugRobot::STATE_TURN;
+    co_await s.turn(robot.rw_angle);
+    robot.generateRW();
+}
+
+#endif // INCLUDED_BEHAVIOUR_HH_
@@ -0,0 +1,167 @@
+#ifndef INCLUDED_CHECKPOINT_HH_
+#define INCLUDED_CHECKPOINT_HH_
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Checkpoints of the controller state, to branch experiments from a warm
+// simulation instead of starting every variant at t = 0.
+//
+//   RUGBOT_CHECKPOINT_TIME=<s> RUGBOT_CHECKPOINT_DIR=<dir>
+//       the supervisor saves <dir>/checkpoint.wbt at the first step at or
+//       after <s> seconds, every controller saves checkpoint_<name>.txt
+//   RUGBOT_RESTORE_DIR=<dir>
+//       start webots on <dir>/checkpoint.wbt; supervisor and controllers
+//       load their state from <dir> before the first step
+//
+// Every class serialises itself through one template method,
+//   template <class Archive> void checkpoint(Archive &ar);
+// calling ar.field("name", member) for each member, so saving and loading
+// cannot drift apart. Files are text with one "name value" pair per line.
+// Work that only belongs to a restore goes under if (ar.restoring()).
+//
+// CheckpointReader::load() parses the whole archive into scratch values
+// first and only assigns the members when every field was read, so a
+// truncated or corrupt file leaves the running state untouched.
+
+class CheckpointWriter {
+public:
+    static const bool loading = false;
+
+    explicit CheckpointWriter(const std::string &path) : out(path) {
+        out << std::setprecision(17);
+    }
+    bool good() const { return out.good(); }
+    bool restoring() const { return false; }
+
+    template <class T> void field(const char *name, T &value) {
+        out << name << ' ';
+        put(value);
+        out << '\n';
+    }
+
+private:
+    std::ofstream out;
+
+    template <class T> void put(T &value) {
+        if constexpr (std::is_enum<T>::value) {
+            out << (int) value;
+        } else {
+            out << value;
+        }
+    }
+    template <class T> void put(std::vector<T> &values) {
+        out << values.size();
+        for (const T &v : values) {
+            out << ' ' << v;
+        }
+    }
+};
+
+class CheckpointReader {
+public:
+    static const bool loading = true;
+
+    explicit CheckpointReader(const std::string &path) : in(path), ok(in.good()) {
+        if (ok) {
+            in.seekg(0, std::ios::end);
+            size = in.tellg();
+            in.seekg(0);
+        }
+    }
+    bool good() const { return ok; }
+    // False while load() only checks the archive
+    bool restoring() const { return !checking; }
+    // Name of the first field that did not match, if any
+    const std::string &error() const { return bad_field; }
+
+    // Calls apply(*this) once to check the whole archive without touching
+    // the members, then once more to load it if that succeeded.
+    template <class F> bool load(F apply) {
+        checking = true;
+        apply(*this);
+        checking = false;
+        if (!ok) {
+            return false;
+        }
+        in.clear();
+        in.seekg(0);
+        apply(*this);
+        return ok;
+    }
+
+    template <class T> void field(const char *name, T &value) {
+        std::string key;
+        if (!ok || !(in >> key) || key != name) {
+            fail(name);
+            return;
+        }
+        // Some standard extractors (random engines) do not skip whitespace
+        in >> std::ws;
+        if (checking) {
+            T scratch{};
+            get(scratch);
+        } else {
+            get(value);
+        }
+        if (!in) {
+            fail(name);
+        }
+    }
+
+private:
+    std::ifstream in;
+    std::streamoff size = 0;
+    bool ok;
+    bool checking = false;
+    std::string bad_field;
+
+    void fail(const char *name) {
+        if (ok) {
+            bad_field = name;
+        }
+        ok = false;
+    }
+    template <class T> void get(T &value) {
+        if constexpr (std::is_enum<T>::value) {
+            int v;
+            in >> v;
+            value = (T) v;
+        } else {
+            in >> value;
+        }
+    }
+    template <class T> void get(std::vector<T> &values) {
+        std::size_t n;
+        in >> n;
+        // Every element takes at least two characters, " x"; a count the
+        // rest of the file cannot hold is corrupt and is not allocated
+        std::streamoff rest = in ? size - (std::streamoff) in.tellg() : 0;
+        if (!in || n > (std::size_t) (rest / 2)) {
+            in.setstate(std::ios::failbit);
+            return;
+        }
+        values.resize(n);
+        for (T &v : values) {
+            in >> v;
+        }
+    }
+};
+
+// Checkpoint time in seconds from RUGBOT_CHECKPOINT_TIME, or -1 when no
+// checkpoint should be taken.
+inline double checkpointTime() {
+    const char *time = getenv("RUGBOT_CHECKPOINT_TIME");
+    const char *dir = getenv("RUGBOT_CHECKPOINT_DIR");
+    return (time != NULL && dir != NULL) ? atof(time) : -1.0;
+}
+
+inline std::string checkpointPath(const char *dir, const std::string &file) {
+    return std::string(dir) + "/" + file;
+}
+
+#endif // INCLUDED_CHECKPOINT_HH_
@@ -0,0 +1,227 @@
+#ifndef INCLUDED_PROFILING_HH_
+#define INCLUDED_PROFILING_HH_
+
+// Step latency and state-machine profiling for the controllers.
+//
+// Build with -DRUGBOT_PROFILE (see the Makefile) to enable. Without the flag
+// every PROF_* macro expands to nothing and none of the classes below exist,
+// so a normal build carries no instrumentation at all.
+//
+//   PROF_SCOPE(hist)          time the enclosing scope into rugbotProfile.hist
+//   PROF_STATE(machine, s, ms)  count one step of ms simulated milliseconds
+//                             spent in state s of a state machine
+//   PROF_REPORT(name, t)      dump everything to std::cout (t = simulated time)
+
+#ifdef RUGBOT_PROFILE
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <time.h>
+
+inline uint64_t profNowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+
+// Log-linear (HDR style) latency histogram: every power of two is split into
+// 2^SUB_BITS linear buckets, which keeps the relative error below ~3% from
+// nanoseconds up to minutes. Owned by a single thread, so recording is a
+// couple of plain increments without locks or atomics.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 5;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int N_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t counts[N_BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t sum_ns = 0;
+    uint64_t max_ns = 0;
+
+    void record(uint64_t ns);
+    uint64_t percentile(double p) const;
+    double mean() const { return total ? (double) sum_ns / total : 0.0; }
+
+private:
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketUpper(int bucket);
+};
+
+inline int LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns < (uint64_t) SUB_COUNT) {
+        return (int) ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - SUB_BITS;
+    return (shift + 1) * SUB_COUNT + (int) ((ns >> shift) - SUB_COUNT);
+}
+
+inline uint64_t LatencyHistogram::bucketUpper(int bucket) {
+    if (bucket < SUB_COUNT) {
+        return (uint64_t) bucket;
+    }
+    int shift = bucket / SUB_COUNT - 1;
+    uint64_t base = (uint64_t) (bucket % SUB_COUNT + SUB_COUNT) << shift;
+    return base + ((1ull << shift) - 1);
+}
+
+inline void LatencyHistogram::record(uint64_t ns) {
+    ++counts[bucketOf(ns)];
+    ++total;
+    sum_ns += ns;
+    if (ns > max_ns) {
+        max_ns = ns;
+    }
+}
+
+inline uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t) (p / 100.0 * (double) (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < N_BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t upper = bucketUpper(i);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram &hist) : hist(hist), start(profNowNs()) {}
+    ~ScopedTimer() { hist.record(profNowNs() - start); }
+
+private:
+    LatencyHistogram &hist;
+    uint64_t start;
+};
+
+
+// Per-state step counts, simulated and wall time and transition counts for
+// one state machine with up to N_STATES states. sample() is called once per
+// control step with the state the machine is in after that step and the
+// simulated time the step covered, which is more than one time step while
+// the robot sleeps (RugRobot::sleepSteps).
+class StateProfile {
+public:
+    static const int N_STATES = 16;
+
+    uint64_t steps[N_STATES] = {};
+    uint64_t sim_ms[N_STATES] = {};
+    uint64_t wall_ns[N_STATES] = {};
+    uint64_t transitions[N_STATES][N_STATES] = {};
+
+    void sample(int s, int ms);
+    void report(std::ostream &out, const char *title, const char *const *names, int n_states) const;
+
+private:
+    int current = -1;
+    uint64_t last_ns = 0;
+};
+
+inline void StateProfile::sample(int s, int ms) {
+    if (s < 0 || s >= N_STATES) {
+        return;
+    }
+    uint64_t now = profNowNs();
+    if (current >= 0) {
+        wall_ns[current] += now - last_ns;
+        if (current != s) {
+            ++transitions[current][s];
+        }
+    }
+    ++steps[s];
+    sim_ms[s] += (uint64_t) ms;
+    current = s;
+    last_ns = now;
+}
+
+inline void StateProfile::report(std::ostream &out, const char *title, const char *const *names,
+                                 int n_states) const {
+    uint64_t total_ms = 0;
+    for (int i = 0; i < n_states; ++i) {
+        total_ms += sim_ms[i];
+    }
+    out << "  " << title << " states (steps, share of simulated time, wall ms):\n";
+    for (int i = 0; i < n_states; ++i) {
+        if (steps[i] == 0) {
+            continue;
+        }
+        out << "    " << std::setw(12) << std::left << names[i] << std::right
+            << std::setw(9) << steps[i]
+            << std::setw(8) << std::fixed << std::setprecision(1)
+            << 100.0 * sim_ms[i] / total_ms << '%'
+            << std::setw(11) << std::setprecision(2) << wall_ns[i] / 1e6 << '\n';
+    }
+    out << "  " << title << " transitions:\n";
+    for (int i = 0; i < n_states; ++i) {
+        for (int j = 0; j < n_states; ++j) {
+            if (transitions[i][j] != 0) {
+                out << "    " << names[i] << " -> " << names[j] << ": " << transitions[i][j] << '\n';
+            }
+        }
+    }
+}
+
+
+struct ControllerProfile {
+    LatencyHistogram step_latency;     // time blocked in Robot::step()
+    LatencyHistogram control_latency;  // controller work between two steps
+    LatencyHistogram random_walk_latency;
+
+    StateProfile algo_states;
+    StateProfile robot_states;
+
+    void report(std::ostream &out, const std::string &name, double sim_time) const;
+};
+
+inline void printLatency(std::ostream &out, const char *title, const LatencyHistogram &h) {
+    out << "  " << std::setw(20) << std::left << title << std::right << std::fixed << std::setprecision(1)
+        << " n=" << h.total
+        << " mean=" << h.mean() / 1e3 << "us"
+        << " p50=" << h.percentile(50) / 1e3 << "us"
+        << " p99=" << h.percentile(99) / 1e3 << "us"
+        << " max=" << h.max_ns / 1e3 << "us\n";
+}
+
+inline void ControllerProfile::report(std::ostream &out, const std::string &name, double sim_time) const {
+    static const char *const algo_names[] = {"RW", "OBS", "PAUSE"};
+    static const char *const robot_names[] = {"FW", "BW", "TR", "CA", "TURN", "RL", "PAUSE", "RESET", "RECV", "SEND"};
+
+    out << "PROFILE " << name << " (" << std::fixed << std::setprecision(2) << sim_time << " s simulated)\n";
+    printLatency(out, "step", step_latency);
+    printLatency(out, "control", control_latency);
+    printLatency(out, "RandomWalk", random_walk_latency);
+    algo_states.report(out, "Algorithm1", algo_names, sizeof(algo_names) / sizeof(algo_names[0]));
+    robot_states.report(out, "RugRobot", robot_names, sizeof(robot_names) / sizeof(robot_names[0]));
+    out.flush();
+}
+
+// One profile per controller thread; a controller process has exactly one.
+inline thread_local ControllerProfile rugbotProfile;
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+#define PROF_SCOPE(hist) ScopedTimer PROF_CONCAT(prof_timer_, __LINE__)(rugbotProfile.hist)
+#define PROF_STATE(machine, s, ms) rugbotProfile.machine.sample((int) (s), (ms))
+#define PROF_REPORT(name, t) rugbotProfile.report(std::cout, (name), (t))
+
+#else
+
+#define PROF_SCOPE(hist)
+#define PROF_STATE(machine, s, ms) do {} while (0)
+#define PROF_REPORT(name, t) do {} while (0)
+
+#endif // RUGBOT_PROFILE
+
+#endif // INCLUDED_PROFILING_HH_
@@ -7,6 +7,8 @@
 #include <webots/Supervisor.hpp>
 #include <iterator> // for ostream_iterator
 
+#include "trace.hh"
+
 
 using namespace webots;
 
@@ -18,12 +20,19 @@ class Radio_Rover
 {
     Emitter *emitter;
     Receiver *receiver;
+    // Packets taken off the receiver queue for a checkpoint, delivered
+    // before the queue on the next getMessages()
+    std::vector<int> pending;
 
     public:
         Radio_Rover() = default;
         Radio_Rover(Supervisor *robot, int d_);
+        // size in bytes
         void sendMessage(const int *data, int size);
-        std::vector<int> getMessages();
+        void getMessages(std::vector<int> &messages);
+        void holdQueued();
+
+        template <class Archive> void checkpoint(Archive &ar);
 };
 
 Radio_Rover::Radio_Rover(Supervisor *robot, int timeStep)
@@ -38,24 +47,49 @@ void Radio_Rover::sendMessage(const int *data, int size)
 {
    
     emitter->send(data, size);
+    if (activeTrace != nullptr) {
+        activeTrace->recordSent(data, size);
+    }
     
     
 }
 
-std::vector<int> Radio_Rover::getMessages()
+// Fills messages with all queued packets; keeps its capacity between steps.
+void Radio_Rover::getMessages(std::vector<int> &messages)
 {
-    std::vector<int> messages;
+    messages.assign(pending.begin(), pending.end());
+    pending.clear();
     
     while (receiver->getQueueLength() > 0) 
     {
         int temp = *(const int*) receiver->getData();
+        if (activeTrace != nullptr) {
+            activeTrace->recordReceived(receiver->getData(), receiver->getDataSize());
+        }
         messages.push_back(temp);   
 
         
         receiver->nextPacket();
     }
-   
-    return messages;
+}
+
+// Move the queued packets into pending so they can be checkpointed
+void Radio_Rover::holdQueued()
+{
+    while (receiver->getQueueLength() > 0)
+    {
+        pending.push_back(*(const int*) receiver->getData());
+        receiver->nextPacket();
+    }
+}
+
+template <class Archive>
+void Radio_Rover::checkpoint(Archive &ar)
+{
+    if (!Archive::loading) {
+        holdQueued();
+    }
+    ar.field("radio_pending", pending);
 }
 
 #endif
\ No newline at end of file
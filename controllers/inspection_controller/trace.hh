@@ -0,0 +1,253 @@
+#ifndef INCLUDED_TRACE_HH_
+#define INCLUDED_TRACE_HH_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Binary sensor trace of one controller run, used to replay the controller
+// offline (tools/trace_replay). Set RUGBOT_TRACE=<dir> before starting
+// Webots and every robot writes <dir>/trace_<name>.bin.
+//
+// Layout (native byte order):
+//   header  "RBTR", version, time step, name, distance sensor names,
+//           initial pose, initial distance to the nearest other robot
+//   frames  one per control step: the sensor values and the distance to the
+//           nearest other robot seen after step() returned, the packets the
+//           controller consumed and sent, and the motor velocities it
+//           commanded before the next step()
+
+struct TracePacket {
+    std::vector<char> data;
+};
+
+struct TraceFrame {
+    static const int MAX_SENSORS = 8;
+
+    uint32_t duration = 0;  // ms passed to step()
+    double time = 0;        // simulated time after step()
+    double distance[MAX_SENSORS] = {};
+    double gyro[3] = {};
+    double accel[3] = {};
+    double pose[3] = {};
+    double nearest = INFINITY;  // centre distance to the nearest other robot, m
+    double motor_left = 0;
+    double motor_right = 0;
+    std::vector<TracePacket> received;
+    std::vector<TracePacket> sent;
+    std::size_t n_received = 0;  // used entries of received/sent, the rest
+    std::size_t n_sent = 0;      // is kept allocated for the next frame
+
+    void clear() { n_received = 0; n_sent = 0; }
+    static void addPacket(std::vector<TracePacket> &packets, std::size_t &n, const void *data, int size);
+};
+
+struct TraceHeader {
+    uint32_t time_step = 0;
+    std::string name;
+    std::vector<std::string> sensor_names;
+    double initial_pose[3] = {};
+    double initial_nearest = INFINITY;
+};
+
+inline void TraceFrame::addPacket(std::vector<TracePacket> &packets, std::size_t &n, const void *data, int size) {
+    if (n == packets.size()) {
+        packets.emplace_back();
+    }
+    packets[n].data.assign((const char *) data, (const char *) data + size);
+    ++n;
+}
+
+
+class TraceWriter {
+public:
+    TraceWriter(const std::string &path, const TraceHeader &header);
+    ~TraceWriter();
+    bool isOpen() const { return file != nullptr; }
+
+    TraceFrame frame;
+    // A frame is pending between the end of step() and the next step() call.
+    bool pending = false;
+
+    void recordReceived(const void *data, int size);
+    void recordSent(const void *data, int size);
+    void endFrame(double motor_left, double motor_right);
+
+private:
+    FILE *file;
+    std::size_t n_sensors;
+
+    void write(const void *data, std::size_t size) { fwrite(data, 1, size, file); }
+    void writeU32(uint32_t v) { write(&v, sizeof(v)); }
+    void writeString(const std::string &s);
+    void writePackets(const std::vector<TracePacket> &packets, std::size_t n);
+};
+
+inline TraceWriter::TraceWriter(const std::string &path, const TraceHeader &header)
+    : file(fopen(path.c_str(), "wb")), n_sensors(header.sensor_names.size()) {
+    if (file == nullptr) {
+        return;
+    }
+    write("RBTR", 4);
+    writeU32(2);
+    writeU32(header.time_step);
+    writeString(header.name);
+    writeU32((uint32_t) n_sensors);
+    for (const std::string &s : header.sensor_names) {
+        writeString(s);
+    }
+    write(header.initial_pose, sizeof(header.initial_pose));
+    write(&header.initial_nearest, sizeof(double));
+}
+
+inline TraceWriter::~TraceWriter() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+inline void TraceWriter::writeString(const std::string &s) {
+    writeU32((uint32_t) s.size());
+    write(s.data(), s.size());
+}
+
+inline void TraceWriter::writePackets(const std::vector<TracePacket> &packets, std::size_t n) {
+    writeU32((uint32_t) n);
+    for (std::size_t i = 0; i < n; ++i) {
+        writeU32((uint32_t) packets[i].data.size());
+        write(packets[i].data.data(), packets[i].data.size());
+    }
+}
+
+inline void TraceWriter::recordReceived(const void *data, int size) {
+    if (pending) {
+        TraceFrame::addPacket(frame.received, frame.n_received, data, size);
+    }
+}
+
+inline void TraceWriter::recordSent(const void *data, int size) {
+    if (pending) {
+        TraceFrame::addPacket(frame.sent, frame.n_sent, data, size);
+    }
+}
+
+inline void TraceWriter::endFrame(double motor_left, double motor_right) {
+    if (!pending || file == nullptr) {
+        return;
+    }
+    frame.motor_left = motor_left;
+    frame.motor_right = motor_right;
+    writeU32(frame.duration);
+    write(&frame.time, sizeof(double));
+    write(frame.distance, n_sensors * sizeof(double));
+    write(frame.gyro, sizeof(frame.gyro));
+    write(frame.accel, sizeof(frame.accel));
+    write(frame.pose, sizeof(frame.pose));
+    write(&frame.nearest, sizeof(double));
+    write(&frame.motor_left, sizeof(double));
+    write(&frame.motor_right, sizeof(double));
+    writePackets(frame.received, frame.n_received);
+    writePackets(frame.sent, frame.n_sent);
+    frame.clear();
+    pending = false;
+}
+
+
+class TraceReader {
+public:
+    explicit TraceReader(const std::string &path);
+    ~TraceReader();
+    bool isOpen() const { return ok; }
+
+    TraceHeader header;
+    bool next(TraceFrame &frame);
+
+private:
+    FILE *file;
+    bool ok = false;
+
+    bool read(void *data, std::size_t size) { return fread(data, 1, size, file) == size; }
+    bool readU32(uint32_t &v) { return read(&v, sizeof(v)); }
+    bool readString(std::string &s);
+    bool readPackets(std::vector<TracePacket> &packets, std::size_t &n);
+};
+
+inline TraceReader::TraceReader(const std::string &path) : file(fopen(path.c_str(), "rb")) {
+    if (file == nullptr) {
+        return;
+    }
+    char magic[4];
+    uint32_t version, n_sensors;
+    if (!read(magic, 4) || std::memcmp(magic, "RBTR", 4) != 0 || !readU32(version) || version != 2) {
+        return;
+    }
+    if (!readU32(header.time_step) || !readString(header.name) || !readU32(n_sensors) ||
+        n_sensors > (uint32_t) TraceFrame::MAX_SENSORS) {
+        return;
+    }
+    header.sensor_names.resize(n_sensors);
+    for (std::string &s : header.sensor_names) {
+        if (!readString(s)) {
+            return;
+        }
+    }
+    ok = read(header.initial_pose, sizeof(header.initial_pose)) && read(&header.initial_nearest, sizeof(double));
+}
+
+inline TraceReader::~TraceReader() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+inline bool TraceReader::readString(std::string &s) {
+    uint32_t size;
+    if (!readU32(size)) {
+        return false;
+    }
+    s.resize(size);
+    return read(&s[0], size);
+}
+
+inline bool TraceReader::readPackets(std::vector<TracePacket> &packets, std::size_t &n) {
+    uint32_t count, size;
+    if (!readU32(count)) {
+        return false;
+    }
+    if (packets.size() < count) {
+        packets.resize(count);
+    }
+    for (n = 0; n < count; ++n) {
+        if (!readU32(size)) {
+            return false;
+        }
+        packets[n].data.resize(size);
+        if (!read(packets[n].data.data(), size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool TraceReader::next(TraceFrame &frame) {
+    if (!ok) {
+        return false;
+    }
+    std::size_t n_sensors = header.sensor_names.size();
+    ok = readU32(frame.duration) && read(&frame.time, sizeof(double)) &&
+         read(frame.distance, n_sensors * sizeof(double)) && read(frame.gyro, sizeof(frame.gyro)) &&
+         read(frame.accel, sizeof(frame.accel)) && read(frame.pose, sizeof(frame.pose)) &&
+         read(&frame.nearest, sizeof(double)) &&
+         read(&frame.motor_left, sizeof(double)) && read(&frame.motor_right, sizeof(double)) &&
+         readPackets(frame.received, frame.n_received) && readPackets(frame.sent, frame.n_sent);
+    return ok;
+}
+
+// Recorder of the running controller, if any. Set by RugRobot so the radio
+// can log the packets it consumes and sends.
+inline thread_local TraceWriter *activeTrace = nullptr;
+
+#endif // INCLUDED_TRACE_HH_
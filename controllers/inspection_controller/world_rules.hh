@@ -0,0 +1,11 @@
+#ifndef INCLUDED_WORLD_RULES_HH_
+#define INCLUDED_WORLD_RULES_HH_
+
+// Rules of the simulated world that the supervisor enforces and the robot
+// controllers have to anticipate; included by both.
+
+// cpp_supervisor moves a robot to a random spot when its centre comes closer
+// than this to another robot's centre, m
+const double RELOCATE_DISTANCE = 0.03;
+
+#endif // INCLUDED_WORLD_RULES_HH_
@@ -47,6 +47,8 @@ time timeout $WB_TIMEOUT webots --minimize --batch --mode=fast --stdout --stderr
 
 
 mv $WB_WORKING_DIR/webots_log.txt ${OUTPUT_DIR}/webots_log_${INSTANCE_ID}.txt
+# Controller outputs, written to WB_WORKING_DIR by cpp_supervisor and every robot
+mv $WB_WORKING_DIR/data_rov.txt $WB_WORKING_DIR/freq_mag_output_*.txt ${OUTPUT_DIR}/ 2>/dev/null
 
 rm -r $JOB_BASE_DIR
 
@@ -0,0 +1,74 @@
+#include <cmath>
+
+#include "beta_belief.hh"
+
+void BetaBelief::update(bool below, double learning_rate) {
+    const double total = alpha + beta;
+    if (below) {
+        beta += beta / total * learning_rate;
+    } else {
+        alpha += alpha / total * learning_rate;
+    }
+}
+
+double BetaBelief::mode() const {
+    return (alpha - 1) / (alpha + beta - 2);
+}
+
+// Exact mass of the interval; beta_dist_test.py approximates the same
+// integral with a 500-point Riemann sum of the pdf.
+double BetaBelief::confidence(double center, double half_width) const {
+    return incompleteBeta(alpha, beta, center + half_width) - incompleteBeta(alpha, beta, center - half_width);
+}
+
+// Continued fraction of I_x(a, b), modified Lentz's method
+static double betaContinuedFraction(double a, double b, double x) {
+    const int MAX_ITERATIONS = 300;
+    const double EPS = 1e-15;
+    const double TINY = 1e-300;
+
+    const double qab = a + b;
+    const double qap = a + 1;
+    const double qam = a - 1;
+    double c = 1;
+    double d = 1 - qab * x / qap;
+    if (std::abs(d) < TINY) d = TINY;
+    d = 1 / d;
+    double h = d;
+    for (int m = 1; m <= MAX_ITERATIONS; ++m) {
+        const int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+        d = 1 + aa * d;
+        if (std::abs(d) < TINY) d = TINY;
+        c = 1 + aa / c;
+        if (std::abs(c) < TINY) c = TINY;
+        d = 1 / d;
+        h *= d * c;
+
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+        d = 1 + aa * d;
+        if (std::abs(d) < TINY) d = TINY;
+        c = 1 + aa / c;
+        if (std::abs(c) < TINY) c = TINY;
+        d = 1 / d;
+        const double delta = d * c;
+        h *= delta;
+        if (std::abs(delta - 1) < EPS) {
+            break;
+        }
+    }
+    return h;
+}
+
+double incompleteBeta(double a, double b, double x) {
+    if (!(a > 0) || !(b > 0) || std::isnan(x)) return NAN;
+    if (x <= 0) return 0;
+    if (x >= 1) return 1;
+    const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) +
+                                  b * std::log1p(-x));
+    // The continued fraction converges fastest below the mean
+    if (x < (a + 1) / (a + b + 2)) {
+        return front * betaContinuedFraction(a, b, x) / a;
+    }
+    return 1 - front * betaContinuedFraction(b, a, 1 - x) / b;
+}
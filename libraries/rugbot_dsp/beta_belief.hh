@@ -0,0 +1,28 @@
+#ifndef INCLUDED_BETA_BELIEF_HH_
+#define INCLUDED_BETA_BELIEF_HH_
+
+// Beta distributed belief about a quantity scaled to [0, 1], updated one
+// observation at a time as in measurements/beta_dist_test.py: an observation
+// below the reference adds to beta, any other to alpha, in proportion to
+// the current weight of that side.
+struct BetaBelief {
+    double alpha = 2;
+    double beta = 2;
+
+    void update(bool below, double learning_rate);
+    // Mode (alpha - 1) / (alpha + beta - 2), for alpha, beta > 1
+    double mode() const;
+    // Probability that the quantity lies within center +- half_width
+    double confidence(double center, double half_width) const;
+
+    template <class Archive> void checkpoint(Archive &ar) {
+        ar.field("beta_alpha", alpha);
+        ar.field("beta_beta", beta);
+    }
+};
+
+// Regularized incomplete beta function I_x(a, b), the Beta(a, b) CDF.
+// NaN unless a > 0 and b > 0.
+double incompleteBeta(double a, double b, double x);
+
+#endif // INCLUDED_BETA_BELIEF_HH_
@@ -0,0 +1,384 @@
+// File:          dsp_bench.cpp
+// Description:   Micro-benchmark and accuracy check for the rugbot_dsp kernels.
+//                Prints ns/sample, heap allocations per call and throughput
+//                for window sizes 64..16384, then compares the kernels with the
+//                golden vectors exported by measurements/export_golden_vectors.py,
+//                and reports the error of the float, Q15 and Q31 kernels
+//                against the double-precision reference, and checks that the
+//                spectral estimator stops early only on clear peaks.
+//
+// Usage:         ./dsp_bench [golden dir] [--no-timing]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "filtering.hh"
+#include "spectral_estimator.hh"
+
+// Count every heap allocation made by the process.
+static unsigned long long n_allocations = 0;
+
+void *operator new(std::size_t size) {
+    ++n_allocations;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+// Keeps the optimiser from dropping benchmarked results.
+static volatile double sink;
+
+// Butterworth coefficients of measurements/test.py (order 2, 15 Hz at 200 Hz)
+static const std::vector<double> butter_b = {0.04125353, 0.08250707, 0.04125353};
+static const std::vector<double> butter_a = {1.0, -1.34896775, 0.51398189};
+
+struct BenchResult {
+    double ns_per_call;
+    double allocs_per_call;
+};
+
+BenchResult runBench(const std::function<void()> &kernel) {
+    typedef std::chrono::steady_clock Clock;
+    kernel();
+
+    // Calibrate the batch size to roughly 20 ms
+    long iterations = 1;
+    while (true) {
+        auto t0 = Clock::now();
+        for (long i = 0; i < iterations; ++i) kernel();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        if (ns > 2e7 || iterations > (1L << 24)) break;
+        iterations *= 2;
+    }
+
+    // Median of five batches
+    std::vector<double> samples;
+    unsigned long long allocs = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+        unsigned long long a0 = n_allocations;
+        auto t0 = Clock::now();
+        for (long i = 0; i < iterations; ++i) kernel();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        allocs += n_allocations - a0;
+        samples.push_back(ns / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return {samples[2], (double) allocs / (5.0 * iterations)};
+}
+
+void printResult(const char *kernel, std::size_t n, const BenchResult &r) {
+    std::printf("%-22s %6zu %12.1f %10.3f %10.2f %10.1f\n", kernel, n, r.ns_per_call, r.ns_per_call / n,
+                r.allocs_per_call, 1e3 / (r.ns_per_call / n));
+}
+
+// Time fftT<T> on a copy of the signal
+template <class T>
+BenchResult benchFftT(const Array &signal) {
+    typedef SampleTraits<T> Traits;
+    std::vector<ComplexOf<T>> input(signal.size()), work(signal.size());
+    for (std::size_t i = 0; i < signal.size(); ++i) {
+        input[i] = ComplexOf<T>(Traits::fromDouble(0.5 * signal[i]), Traits::fromDouble(0.0));
+    }
+    return runBench([&] {
+        std::copy(input.begin(), input.end(), work.begin());
+        sink = fftT<T>(work);
+    });
+}
+
+void runTimings() {
+    std::printf("%-22s %6s %12s %10s %10s %10s\n", "kernel", "N", "ns/call", "ns/sample", "allocs", "Msamples/s");
+
+    std::mt19937 gen(1);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    for (std::size_t n = 64; n <= 16384; n *= 2) {
+        Array signal(n);
+        for (double &v : signal) v = noise(gen);
+        CArray spectrum(signal.begin(), signal.end());
+        fft(spectrum);
+        Array magnitude = compute_abs_fft(spectrum);
+
+        CArray work(n);
+        printResult("fft", n, runBench([&] {
+            std::copy(signal.begin(), signal.end(), work.begin());
+            fft(work);
+            sink = work[1].real();
+        }));
+        printResult("fftT<float>", n, benchFftT<float>(signal));
+        printResult("fftT<Q31>", n, benchFftT<Q31>(signal));
+        printResult("fftT<Q15>", n, benchFftT<Q15>(signal));
+        printResult("compute_abs_fft", n, runBench([&] { sink = compute_abs_fft(spectrum)[1]; }));
+        printResult("butter_lowpass_filter", n, runBench([&] {
+            sink = butter_lowpass_filter(signal, 10.0, 50.0)[n - 1];
+        }));
+        printResult("forwardButterworth", n, runBench([&] {
+            sink = forwardButterworth(butter_b, butter_a, magnitude)[n - 1];
+        }));
+        printResult("backwardButterworth", n, runBench([&] {
+            sink = backwardButterworth(butter_b, butter_a, magnitude)[0];
+        }));
+        // One block per call, the controller feeds one sample per step
+        SpectralEstimator estimator(n, 50.0, 1.0, 24.0);
+        printResult("SpectralEstimator", n, runBench([&] {
+            for (double v : signal) estimator.addSample(v);
+            sink = estimator.separation();
+        }));
+    }
+}
+
+Array loadVector(const std::string &path) {
+    Array values;
+    std::ifstream file(path);
+    double v;
+    while (file >> v) {
+        values.push_back(v);
+    }
+    return values;
+}
+
+// Largest absolute error relative to the largest reference value.
+double relError(const Array &result, const Array &golden) {
+    if (result.size() != golden.size() || golden.empty()) {
+        return INFINITY;
+    }
+    double err = 0, scale = 0;
+    for (std::size_t i = 0; i < golden.size(); ++i) {
+        err = std::max(err, std::abs(result[i] - golden[i]));
+        scale = std::max(scale, std::abs(golden[i]));
+    }
+    return scale > 0 ? err / scale : err;
+}
+
+bool report(const char *kernel, std::size_t n, double err, double tolerance) {
+    bool ok = err <= tolerance;
+    std::printf("%-22s %6zu  rel. error %.3e  %s\n", kernel, n, err, ok ? "OK" : "FAIL");
+    return ok;
+}
+
+// Error of one sample type against the double reference: FFT magnitude
+// (after undoing the block exponent), forward Butterworth pass and the
+// detected spectral peak.
+template <class T>
+void reportPrecision(const char *type, const Array &signal, const Array &ref_mag, const Array &ref_iir) {
+    typedef SampleTraits<T> Traits;
+    const std::size_t n = signal.size();
+
+    std::vector<ComplexOf<T>> spectrum(n);
+    std::vector<T> in(n), mag, iir;
+    for (std::size_t i = 0; i < n; ++i) {
+        in[i] = Traits::fromDouble(signal[i]);
+        spectrum[i] = ComplexOf<T>(in[i], Traits::fromDouble(0.0));
+    }
+    int exponent = fftT<T>(spectrum);
+    absFftT<T>(spectrum, mag);
+    forwardButterworthT<T>(butter_b, butter_a, in, iir);
+
+    Array mag_d(n), iir_d(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        mag_d[i] = std::ldexp(Traits::toDouble(mag[i]), exponent);
+        iir_d[i] = Traits::toDouble(iir[i]);
+    }
+    std::size_t peak = findPeakT<T>(mag, 1, n / 2);
+    std::size_t ref_peak = findPeak(ref_mag, 1, n / 2);
+
+    std::printf("%-8s %6zu %8d %14.3e %14.3e %6zu %6zu\n", type, n, exponent, relError(mag_d, ref_mag),
+                relError(iir_d, ref_iir), peak, ref_peak);
+}
+
+void runPrecision() {
+    std::printf("%-8s %6s %8s %14s %14s %6s %6s\n", "type", "N", "exponent", "fft rel.err", "iir rel.err",
+                "peak", "ref");
+
+    std::mt19937 gen(2);
+    std::normal_distribution<double> noise(0.0, 0.05);
+    for (std::size_t n : {64, 1024, 16384}) {
+        // Vibration-like test signal within [-1, 1) for the fixed-point types
+        Array signal(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            signal[i] = 0.4 * std::sin(2 * PI * 0.0625 * i) + 0.2 * std::sin(2 * PI * 0.205 * i) + noise(gen);
+        }
+        CArray spectrum(signal.begin(), signal.end());
+        fft(spectrum);
+        Array ref_mag = compute_abs_fft(spectrum);
+        Array ref_iir = forwardButterworth(butter_b, butter_a, signal);
+
+        reportPrecision<float>("float", signal, ref_mag, ref_iir);
+        reportPrecision<Q31>("Q31", signal, ref_mag, ref_iir);
+        reportPrecision<Q15>("Q15", signal, ref_mag, ref_iir);
+    }
+}
+
+int checkGolden(const std::string &dir) {
+    Array b = loadVector(dir + "/butter_b.txt");
+    Array a = loadVector(dir + "/butter_a.txt");
+    if (b.empty() || a.empty()) {
+        std::cerr << "No golden vectors in " << dir
+                  << ", run measurements/export_golden_vectors.py first" << '\n';
+        return 1;
+    }
+
+    const double tolerance = 1e-9;
+    bool ok = true;
+    for (std::size_t n : {64, 1024}) {
+        std::string suffix = "_" + std::to_string(n) + ".txt";
+        Array input = loadVector(dir + "/input" + suffix);
+
+        CArray spectrum(input.begin(), input.end());
+        fft(spectrum);
+        Array magnitude = compute_abs_fft(spectrum);
+        Array forward = forwardButterworth(b, a, loadVector(dir + "/abs_fft" + suffix));
+
+        ok &= report("fft + compute_abs_fft", n, relError(magnitude, loadVector(dir + "/abs_fft" + suffix)), tolerance);
+        ok &= report("butter_lowpass_filter", n,
+                     relError(butter_lowpass_filter(input, 10.0, 50.0), loadVector(dir + "/lowpass" + suffix)), tolerance);
+        ok &= report("forwardButterworth", n, relError(forward, loadVector(dir + "/forward" + suffix)), tolerance);
+        ok &= report("backwardButterworth", n,
+                     relError(backwardButterworth(b, a, loadVector(dir + "/forward" + suffix)),
+                              loadVector(dir + "/backward" + suffix)), tolerance);
+    }
+    return ok ? 0 : 1;
+}
+
+// Observe vibrations the way STATE_OBS does (50 Hz accelerometer, 64-sample
+// blocks): a clear one has to stop at min_blocks, a weak one has to dwell
+// longer, both on the right frequency, and noise alone must not stop before
+// max_blocks on whichever bin happens to be the largest.
+int checkEstimator() {
+    std::mt19937 gen(3);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    enum Expect { CLEAR, WEAK, NOISE };
+    struct Case { const char *name; double amplitude; double noise; Expect expect; };
+    const Case cases[] = {{"clear 7 Hz", 0.2, 0.05, CLEAR}, {"weak 7 Hz", 0.3, 0.2, WEAK}, {"noise only", 0.0, 0.2, NOISE}};
+
+    bool ok = true;
+    for (const Case &c : cases) {
+        SpectralEstimator estimator(64, 50.0, 1.0, 24.0);
+        std::size_t n = 0;
+        do {
+            double t = n++ / 50.0;
+            estimator.addSample(9.81 + c.amplitude * std::sin(2 * PI * 7.0 * t) + c.noise * noise(gen));
+        } while (!(n % 64 == 0 && estimator.done()));
+
+        bool on_peak = std::abs(estimator.peakFrequency() - 7.0) < 0.4;
+        bool pass = c.expect == CLEAR ? estimator.blocks() == estimator.min_blocks && on_peak
+                  : c.expect == WEAK  ? estimator.blocks() > estimator.min_blocks && on_peak
+                                      : estimator.blocks() == estimator.max_blocks;
+        std::printf("SpectralEstimator %-15s blocks %zu  peak %.2f Hz  amplitude %.3f  separation %.1f  %s\n", c.name,
+                    estimator.blocks(), estimator.peakFrequency(), estimator.peakMagnitude(), estimator.separation(),
+                    pass ? "OK" : "FAIL");
+        ok &= pass;
+    }
+    return ok ? 0 : 1;
+}
+
+// Relative error of a fixed-point FFT of a full-scale input, the worst case
+// for the block scaling, against the double FFT of the same samples.
+template <class T>
+double fullScaleFftError(const Array &re, const Array &im) {
+    typedef SampleTraits<T> Traits;
+    const std::size_t n = re.size();
+    std::vector<ComplexOf<T>> spectrum(n);
+    CArray reference(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        spectrum[i] = ComplexOf<T>(Traits::fromDouble(re[i]), Traits::fromDouble(im[i]));
+        reference[i] = Complex(Traits::toDouble(spectrum[i].re), Traits::toDouble(spectrum[i].im));
+    }
+    int exponent = fftT<T>(spectrum);
+    fft(reference);
+
+    std::vector<T> mag;
+    absFftT<T>(spectrum, mag);
+    Array mag_d(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        mag_d[i] = std::ldexp(Traits::toDouble(mag[i]), exponent);
+    }
+    return relError(mag_d, compute_abs_fft(reference));
+}
+
+// Inputs at the limits of the kernels: an FFT size that is not a power of
+// two must be rejected, a filter longer than MAX_IIR_TAPS must use all its
+// coefficients and full-scale fixed-point FFTs must not saturate.
+int checkLimits() {
+    bool ok = true;
+
+    CArray odd(3, Complex(1.0, 0.0));
+    bool rejected = false;
+    try {
+        fft(odd);
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    rejected = rejected && odd == CArray(3, Complex(1.0, 0.0));
+    std::printf("%-22s %6d  %s\n", "fft rejects size", 3, rejected ? "OK" : "FAIL");
+    ok &= rejected;
+
+    // FIR (a = 1) with more taps than MAX_IIR_TAPS against the direct sum
+    const std::size_t taps = MAX_IIR_TAPS + 8;
+    Array b(taps), a = {1.0}, x(256), expected(256, 0.0);
+    for (std::size_t j = 0; j < taps; ++j) {
+        b[j] = 1.0 / (j + 1);
+    }
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        x[i] = std::sin(0.3 * i) + 0.01 * i;
+    }
+    for (std::size_t i = taps; i < x.size(); ++i) {
+        for (std::size_t j = 0; j < taps; ++j) {
+            expected[i] += b[j] * x[i - j];
+        }
+    }
+    ok &= report("forwardButterworth 24", x.size(), relError(forwardButterworth(b, a, x), expected), 1e-12);
+
+    const std::size_t n = 1024;
+    std::mt19937 gen(4);
+    std::bernoulli_distribution sign(0.5);
+    Array ones(n, 1.0), random_re(n), random_im(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        random_re[i] = sign(gen) ? 1.0 : -1.0;
+        random_im[i] = sign(gen) ? 1.0 : -1.0;
+    }
+    ok &= report("Q15 fft full scale", n, fullScaleFftError<Q15>(ones, ones), 1e-3);
+    ok &= report("Q15 fft random sign", n, fullScaleFftError<Q15>(random_re, random_im), 2e-3);
+    ok &= report("Q31 fft full scale", n, fullScaleFftError<Q31>(ones, ones), 1e-7);
+    ok &= report("Q31 fft random sign", n, fullScaleFftError<Q31>(random_re, random_im), 1e-6);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    std::string golden_dir = "../../measurements/golden";
+    bool timing = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-timing") {
+            timing = false;
+        } else {
+            golden_dir = arg;
+        }
+    }
+
+    if (timing) {
+        runTimings();
+        std::printf("\n");
+    }
+    runPrecision();
+    std::printf("\n");
+    int failed = checkEstimator();
+    std::printf("\n");
+    failed |= checkLimits();
+    std::printf("\n");
+    return checkGolden(golden_dir) | failed;
+}
@@ -0,0 +1,97 @@
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "filtering.hh"
+
+
+// Cooley-Tukey FFT (in-place, radix-2, see fftT in filtering_precision.cpp)
+void fft(CArray& x) {
+    fftT<double>(x);
+}
+
+Array createFrequencyArray(double sample_freq, int N_samples) {
+    int half_size = N_samples / 2 + 1;
+    Array freqArray(half_size);
+    double freq_step = sample_freq / N_samples;
+    for (int i = 0; i < half_size; ++i) {
+        freqArray[i] = i * freq_step;
+    }
+    return freqArray;
+}
+
+// Function to perform a first-order Butterworth lowpass filter on absolute values
+std::vector<double> butter_lowpass_filter(const std::vector<double>& data, double cutoff_freq, double sampling_freq) {
+    std::vector<double> filtered_data;
+    butterLowpassT<double>(data, cutoff_freq, sampling_freq, filtered_data);
+    return filtered_data;
+}
+
+// Function to apply Butterworth filter in forward direction and return filtered output
+std::vector<double> forwardButterworth(const std::vector<double>& b, const std::vector<double>& a, const std::vector<double>& fft) {
+    std::vector<double> filtered_fft;
+    forwardButterworthT<double>(b, a, fft, filtered_fft);
+    return filtered_fft;
+}
+
+// Function to apply Butterworth filter in backward direction and return filtered output
+std::vector<double> backwardButterworth(const std::vector<double>& b, const std::vector<double>& a, const std::vector<double>& fft_out) {
+    std::vector<double> filtered_fft;
+    backwardButterworthT<double>(b, a, fft_out, filtered_fft);
+    return filtered_fft;
+}
+
+
+
+// Function to compute absolute values of FFT results (magnitude)
+std::vector<double> compute_abs_fft(const std::vector<std::complex<double>>& fft_results) {
+    std::vector<double> abs_fft_results;
+    absFftT<double>(fft_results, abs_fft_results);
+    return abs_fft_results;
+}
+
+std::size_t findPeak(const Array& magnitude, std::size_t first, std::size_t last) {
+    return findPeakT<double>(magnitude, first, last);
+}
+
+
+int roundToNearest10(int number) {
+    // Calculate the remainder when divided by 10
+    int remainder = number % 10;
+
+    // Determine the nearest multiple of 10
+    if (remainder < 5) {
+        return number - remainder;
+    }
+    return number + (10 - remainder);
+}
+
+std::vector<int> roundToNearest10(const std::vector<int>& numbers) {
+    std::vector<int> rounded_numbers;
+    rounded_numbers.reserve(numbers.size());
+
+    for (int number : numbers) {
+        rounded_numbers.push_back(roundToNearest10(number));
+    }
+
+    return rounded_numbers;
+}
+
+void appendValuesToFile(const std::string& path, const std::vector<double>& peak_freq, const std::vector<double>& peak_mag) {
+    std::ofstream outFile(path, std::ios::app); // Open file for appending
+
+    if (!outFile) {
+        std::cerr << "Failed to open " << path << " for appending!" << std::endl;
+        return;
+    }
+
+    for (size_t i = 0; i < peak_freq.size(); ++i) {
+        outFile  << peak_freq[i]  << "," << (i < peak_mag.size() ? peak_mag[i] : 0.0) << ",";
+    }
+    outFile<<std::endl;
+
+    outFile.close(); // Close the file
+}
@@ -0,0 +1,90 @@
+#ifndef INCLUDED_FILTERING_HH_
+#define INCLUDED_FILTERING_HH_
+
+#include <complex>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "fixed_point.hh"
+
+// Signal processing used by the inspection controller. Built as the
+// standalone rugbot_dsp library (see the Makefile in this directory) so it
+// can be benchmarked and linked without Webots.
+
+const double PI = 3.141592653589793238460;
+
+
+typedef std::complex<double> Complex;
+typedef std::vector<Complex> CArray;
+typedef std::vector<double> Array;
+
+
+// Cooley-Tukey FFT, in-place. The size of x must be a power of two,
+// std::invalid_argument is thrown otherwise.
+void fft(CArray& x);
+
+// Frequencies of the first N_samples / 2 + 1 FFT bins.
+Array createFrequencyArray(double sample_freq, int N_samples);
+
+// First-order lowpass filter, the first output sample equals data[0].
+std::vector<double> butter_lowpass_filter(const std::vector<double>& data, double cutoff_freq, double sampling_freq);
+
+// Butterworth filter (b, a as given by scipy.signal.butter) run forward and
+// backward over a spectrum.
+std::vector<double> forwardButterworth(const std::vector<double>& b, const std::vector<double>& a, const std::vector<double>& fft);
+std::vector<double> backwardButterworth(const std::vector<double>& b, const std::vector<double>& a, const std::vector<double>& fft_out);
+
+// Magnitude of every FFT bin.
+std::vector<double> compute_abs_fft(const std::vector<std::complex<double>>& fft_results);
+
+int roundToNearest10(int number);
+std::vector<int> roundToNearest10(const std::vector<int>& numbers);
+
+// Index of the largest magnitude in [first, last), first if the range is empty.
+std::size_t findPeak(const Array& magnitude, std::size_t first, std::size_t last);
+
+// Append one line of peak frequency, magnitude pairs to the file at path.
+void appendValuesToFile(const std::string& path, const std::vector<double>& peak_freq, const std::vector<double>& peak_mag);
+
+
+// Precision-templated kernels, instantiated for double, float, Q15 and Q31
+// (filtering_precision.cpp). The double functions above use the double
+// instantiation, so they are the reference the others are measured against.
+
+template <class T> using ComplexOf = typename SampleTraits<T>::complex_type;
+
+// Radix-2 FFT, in-place; the size of x must be a power of two. Fixed-point
+// types use block floating point: the block is halved before any stage that
+// could overflow, and the true spectrum is x * 2^(returned exponent).
+// Floating-point types always return 0. Throws std::invalid_argument when
+// the size is not a power of two.
+template <class T> int fftT(std::vector<ComplexOf<T>>& x);
+
+template <class T> void absFftT(const std::vector<ComplexOf<T>>& x, std::vector<T>& out);
+
+template <class T> void butterLowpassT(const std::vector<T>& x, double cutoff_freq, double sampling_freq,
+                                       std::vector<T>& out);
+
+// Filters of up to MAX_IIR_TAPS coefficients run without allocating,
+// longer ones allocate their coefficients on every call.
+const std::size_t MAX_IIR_TAPS = 16;
+template <class T> void forwardButterworthT(const std::vector<double>& b, const std::vector<double>& a,
+                                            const std::vector<T>& x, std::vector<T>& out);
+template <class T> void backwardButterworthT(const std::vector<double>& b, const std::vector<double>& a,
+                                             const std::vector<T>& x, std::vector<T>& out);
+
+template <class T> std::size_t findPeakT(const std::vector<T>& magnitude, std::size_t first, std::size_t last);
+
+// The same kernels on caller-provided buffers of n samples; the vector
+// versions above forward to these. Used by the C ABI in rugbot_native.h.
+template <class T> int fftT(ComplexOf<T>* x, std::size_t n);
+template <class T> void absFftT(const ComplexOf<T>* x, std::size_t n, T* out);
+template <class T> void butterLowpassT(const T* x, std::size_t n, double cutoff_freq, double sampling_freq, T* out);
+template <class T> void forwardButterworthT(const double* b, std::size_t n_b, const double* a, std::size_t n_a,
+                                            const T* x, std::size_t n, T* out);
+template <class T> void backwardButterworthT(const double* b, std::size_t n_b, const double* a, std::size_t n_a,
+                                             const T* x, std::size_t n, T* out);
+template <class T> std::size_t findPeakT(const T* magnitude, std::size_t n, std::size_t first, std::size_t last);
+
+#endif // INCLUDED_FILTERING_HH_
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "filtering.hh"
+
+// Precision-templated DSP kernels, see filtering.hh and fixed_point.hh.
+
+
+// Scale the whole block down by 2^shift, with the smallest shift that brings
+// every component to at most 0.4 (plus one LSB of rounding), and return the
+// shift. One radix-2 stage grows a component by at most 1 + sqrt(2), so the
+// next stage stays below 0.97 and never saturates, whatever the input.
+template <class T>
+static int blockScale(ComplexOf<T>* x, std::size_t n) {
+    if constexpr (SampleTraits<T>::fixed) {
+        typedef decltype(T::saturate(0)) Wide;
+        const Wide limit = T::fromDouble(0.4).raw;
+        Wide largest = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            largest = std::max({largest, std::abs((Wide) x[i].re.raw), std::abs((Wide) x[i].im.raw)});
+        }
+        int shift = 0;
+        for (; largest > limit; ++shift) {
+            largest = T::roundShift(largest, 1);
+        }
+        if (shift > 0) {
+            for (std::size_t i = 0; i < n; ++i) {
+                x[i] = ComplexOf<T>(x[i].re.scaled(shift), x[i].im.scaled(shift));
+            }
+        }
+        return shift;
+    }
+    return 0;
+}
+
+// Iterative radix-2 decimation-in-time FFT, no allocations
+template <class T>
+int fftT(ComplexOf<T>* x, std::size_t N) {
+    typedef SampleTraits<T> Traits;
+    if ((N & (N - 1)) != 0) {
+        throw std::invalid_argument("fft: the size must be a power of two, got " + std::to_string(N));
+    }
+    if (N <= 1) return 0;
+
+    // bit-reversal permutation
+    for (std::size_t i = 1, j = 0; i < N; ++i) {
+        std::size_t bit = N >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(x[i], x[j]);
+        }
+    }
+
+    int exponent = 0;
+    for (std::size_t len = 2; len <= N; len <<= 1) {
+        exponent += blockScale<T>(x, N);
+        const std::size_t half = len / 2;
+        for (std::size_t k = 0; k < half; ++k) {
+            double angle = -2.0 * PI * k / len;
+            ComplexOf<T> w(Traits::fromDouble(std::cos(angle)), Traits::fromDouble(std::sin(angle)));
+            for (std::size_t i = k; i < N; i += len) {
+                ComplexOf<T> u = x[i];
+                ComplexOf<T> t = w * x[i + half];
+                x[i] = u + t;
+                x[i + half] = u - t;
+            }
+        }
+    }
+    return exponent;
+}
+
+template <class T>
+int fftT(std::vector<ComplexOf<T>>& x) {
+    return fftT<T>(x.data(), x.size());
+}
+
+template <class T>
+void absFftT(const ComplexOf<T>* x, std::size_t n, T* out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = SampleTraits<T>::magnitude(x[i]);
+    }
+}
+
+template <class T>
+void absFftT(const std::vector<ComplexOf<T>>& x, std::vector<T>& out) {
+    out.resize(x.size());
+    absFftT<T>(x.data(), x.size(), out.data());
+}
+
+// y[0] = x[0], y[i] = alpha * x[i] + (1 - alpha) * y[i - 1]
+template <class T>
+void butterLowpassT(const T* x, std::size_t n, double cutoff_freq, double sampling_freq, T* out) {
+    typedef SampleTraits<T> Traits;
+    if (n == 0) return;
+
+    double RC = 1.0 / (cutoff_freq * 2 * PI);
+    double dt = 1.0 / sampling_freq;
+    double alpha = dt / (RC + dt);
+    typename Traits::coeff_type c_in = Traits::coeff(alpha);
+    typename Traits::coeff_type c_prev = Traits::coeff(1 - alpha);
+
+    out[0] = x[0];
+    for (std::size_t i = 1; i < n; ++i) {
+        out[i] = Traits::fromAcc(Traits::mul(c_in, x[i]) + Traits::mul(c_prev, out[i - 1]));
+    }
+}
+
+template <class T>
+void butterLowpassT(const std::vector<T>& x, double cutoff_freq, double sampling_freq, std::vector<T>& out) {
+    out.resize(x.size());
+    butterLowpassT<T>(x.data(), x.size(), cutoff_freq, sampling_freq, out.data());
+}
+
+// Filter coefficients in the kernel's coefficient type, len(b) of each.
+// Up to MAX_IIR_TAPS they live on the stack, longer filters use the heap.
+template <class T>
+struct IirCoefficients {
+    typedef typename SampleTraits<T>::coeff_type coeff_type;
+
+    coeff_type stack_b[MAX_IIR_TAPS], stack_a[MAX_IIR_TAPS];
+    std::vector<coeff_type> heap_b, heap_a;
+    coeff_type* b = stack_b;
+    coeff_type* a = stack_a;
+    std::size_t taps;
+
+    // The shorter of b and a is zero-padded, as scipy.signal.lfilter does
+    IirCoefficients(const double* b_in, std::size_t n_b, const double* a_in, std::size_t n_a)
+        : taps(std::max(n_b, n_a)) {
+        if (taps > MAX_IIR_TAPS) {
+            heap_b.resize(taps);
+            heap_a.resize(taps);
+            b = heap_b.data();
+            a = heap_a.data();
+        }
+        for (std::size_t j = 0; j < taps; ++j) {
+            b[j] = SampleTraits<T>::coeff(j < n_b ? b_in[j] : 0.0);
+            a[j] = SampleTraits<T>::coeff(j < n_a ? a_in[j] : 0.0);
+        }
+    }
+};
+
+// Outputs before max(len(b), len(a)) are zero
+template <class T>
+void forwardButterworthT(const double* b, std::size_t n_b, const double* a, std::size_t n_a,
+                         const T* x, std::size_t n, T* out) {
+    typedef SampleTraits<T> Traits;
+    const IirCoefficients<T> c(b, n_b, a, n_a);
+    const std::size_t taps = c.taps;
+    std::fill(out, out + n, T());
+
+    for (std::size_t i = taps; i < n; ++i) {
+        typename Traits::acc_type acc = Traits::mul(c.b[0], x[i]);
+        for (std::size_t j = 1; j < taps; ++j) {
+            acc += Traits::mul(c.b[j], x[i - j]);
+            acc -= Traits::mul(c.a[j], out[i - j]);
+        }
+        out[i] = Traits::fromAcc(acc);
+    }
+}
+
+template <class T>
+void forwardButterworthT(const std::vector<double>& b, const std::vector<double>& a,
+                         const std::vector<T>& x, std::vector<T>& out) {
+    out.resize(x.size());
+    forwardButterworthT<T>(b.data(), b.size(), a.data(), a.size(), x.data(), x.size(), out.data());
+}
+
+// Runs from len - taps down to 0, the last taps - 1 outputs are zero
+template <class T>
+void backwardButterworthT(const double* b, std::size_t n_b, const double* a, std::size_t n_a,
+                          const T* x, std::size_t n, T* out) {
+    typedef SampleTraits<T> Traits;
+    const IirCoefficients<T> c(b, n_b, a, n_a);
+    const std::size_t taps = c.taps;
+    std::fill(out, out + n, T());
+    if (n < taps) return;
+
+    for (std::size_t i = n - taps + 1; i-- > 0;) {
+        typename Traits::acc_type acc = Traits::mul(c.b[0], x[i]);
+        for (std::size_t j = 1; j < taps; ++j) {
+            acc += Traits::mul(c.b[j], x[i + j]);
+            acc -= Traits::mul(c.a[j], out[i + j]);
+        }
+        out[i] = Traits::fromAcc(acc);
+    }
+}
+
+template <class T>
+void backwardButterworthT(const std::vector<double>& b, const std::vector<double>& a,
+                          const std::vector<T>& x, std::vector<T>& out) {
+    out.resize(x.size());
+    backwardButterworthT<T>(b.data(), b.size(), a.data(), a.size(), x.data(), x.size(), out.data());
+}
+
+template <class T>
+std::size_t findPeakT(const T* magnitude, std::size_t n, std::size_t first, std::size_t last) {
+    last = std::min(last, n);
+    std::size_t peak = first;
+    for (std::size_t i = first + 1; i < last; ++i) {
+        if (magnitude[i] > magnitude[peak]) {
+            peak = i;
+        }
+    }
+    return peak;
+}
+
+template <class T>
+std::size_t findPeakT(const std::vector<T>& magnitude, std::size_t first, std::size_t last) {
+    return findPeakT<T>(magnitude.data(), magnitude.size(), first, last);
+}
+
+
+#define INSTANTIATE_DSP(T)                                                                                   \
+    template int fftT<T>(std::vector<ComplexOf<T>>&);                                                        \
+    template void absFftT<T>(const std::vector<ComplexOf<T>>&, std::vector<T>&);                             \
+    template void butterLowpassT<T>(const std::vector<T>&, double, double, std::vector<T>&);                 \
+    template void forwardButterworthT<T>(const std::vector<double>&, const std::vector<double>&,             \
+                                         const std::vector<T>&, std::vector<T>&);                            \
+    template void backwardButterworthT<T>(const std::vector<double>&, const std::vector<double>&,            \
+                                          const std::vector<T>&, std::vector<T>&);                           \
+    template std::size_t findPeakT<T>(const std::vector<T>&, std::size_t, std::size_t);                      \
+    template int fftT<T>(ComplexOf<T>*, std::size_t);                                                        \
+    template void absFftT<T>(const ComplexOf<T>*, std::size_t, T*);                                          \
+    template void butterLowpassT<T>(const T*, std::size_t, double, double, T*);                              \
+    template void forwardButterworthT<T>(const double*, std::size_t, const double*, std::size_t,             \
+                                         const T*, std::size_t, T*);                                         \
+    template void backwardButterworthT<T>(const double*, std::size_t, const double*, std::size_t,            \
+                                          const T*, std::size_t, T*);                                        \
+    template std::size_t findPeakT<T>(const T*, std::size_t, std::size_t, std::size_t);
+
+INSTANTIATE_DSP(double)
+INSTANTIATE_DSP(float)
+INSTANTIATE_DSP(Q15)
+INSTANTIATE_DSP(Q31)
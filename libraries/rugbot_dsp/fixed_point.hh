@@ -0,0 +1,145 @@
+#ifndef INCLUDED_FIXED_POINT_HH_
+#define INCLUDED_FIXED_POINT_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <complex>
+#include <cstdint>
+#include <limits>
+
+// Sample types for the precision-templated DSP kernels (filtering.hh):
+// double, float and the saturating fixed-point formats Q15 and Q31 used on
+// the RugBot microcontroller. Fixed-point values lie in [-1, 1); every
+// operation rounds to nearest and saturates instead of wrapping.
+
+template <int FRAC, class Storage, class Wide>
+struct Fixed {
+    Storage raw = 0;
+
+    static const int frac_bits = FRAC;
+
+    static Fixed fromRaw(Wide v) {
+        Fixed f;
+        f.raw = (Storage) saturate(v);
+        return f;
+    }
+    static Fixed fromDouble(double v) {
+        double scaled = std::ldexp(v, FRAC);
+        scaled = std::fmax(std::fmin(scaled, (double) std::numeric_limits<Storage>::max()),
+                           (double) std::numeric_limits<Storage>::min());
+        return fromRaw((Wide) std::llround(scaled));
+    }
+    double toDouble() const { return std::ldexp((double) raw, -FRAC); }
+
+    static Wide saturate(Wide v) {
+        const Wide hi = std::numeric_limits<Storage>::max();
+        const Wide lo = std::numeric_limits<Storage>::min();
+        return v > hi ? hi : (v < lo ? lo : v);
+    }
+    // Round to nearest and drop `shift` fractional bits
+    static Wide roundShift(Wide v, int shift) { return (v + ((Wide) 1 << (shift - 1))) >> shift; }
+
+    friend Fixed operator+(Fixed a, Fixed b) { return fromRaw((Wide) a.raw + b.raw); }
+    friend Fixed operator-(Fixed a, Fixed b) { return fromRaw((Wide) a.raw - b.raw); }
+    friend Fixed operator-(Fixed a) { return fromRaw(-(Wide) a.raw); }
+    friend Fixed operator*(Fixed a, Fixed b) { return fromRaw(roundShift((Wide) a.raw * b.raw, FRAC)); }
+    friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+
+    // Divide by 2^shift with rounding, used for block-floating-point scaling
+    Fixed scaled(int shift) const { return shift > 0 ? fromRaw(roundShift((Wide) raw, shift)) : *this; }
+};
+
+typedef Fixed<15, int16_t, int32_t> Q15;
+typedef Fixed<31, int32_t, int64_t> Q31;
+
+
+template <class T>
+struct FixedComplex {
+    T re;
+    T im;
+
+    FixedComplex() = default;
+    FixedComplex(T re, T im) : re(re), im(im) {}
+
+    T real() const { return re; }
+    T imag() const { return im; }
+
+    friend FixedComplex operator+(FixedComplex a, FixedComplex b) { return {a.re + b.re, a.im + b.im}; }
+    friend FixedComplex operator-(FixedComplex a, FixedComplex b) { return {a.re - b.re, a.im - b.im}; }
+    // Products accumulated in the wide type before rounding once
+    friend FixedComplex operator*(FixedComplex a, FixedComplex b) {
+        typedef decltype(T::saturate(0)) Wide;
+        Wide re = (Wide) a.re.raw * b.re.raw - (Wide) a.im.raw * b.im.raw;
+        Wide im = (Wide) a.re.raw * b.im.raw + (Wide) a.im.raw * b.re.raw;
+        return {T::fromRaw(T::roundShift(re, T::frac_bits)), T::fromRaw(T::roundShift(im, T::frac_bits))};
+    }
+};
+
+// Integer square root, floor(sqrt(v))
+inline uint64_t isqrt(uint64_t v) {
+    uint64_t result = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= result + bit) {
+            v -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+
+// What the kernels need to know about a sample type: its complex type, the
+// coefficient and accumulator types of the IIR filters and conversions.
+template <class T>
+struct SampleTraits {
+    typedef std::complex<T> complex_type;
+    typedef T coeff_type;
+    typedef T acc_type;
+    static const bool fixed = false;
+
+    static T fromDouble(double v) { return (T) v; }
+    static double toDouble(T v) { return (double) v; }
+    static coeff_type coeff(double c) { return (T) c; }
+    static acc_type mul(coeff_type c, T x) { return c * x; }
+    static T fromAcc(acc_type a) { return a; }
+    static T magnitude(const complex_type &c) { return std::abs(c); }
+};
+
+// Fixed point: IIR coefficients are Q24 (|c| < 128, so they fit 32 bits) and
+// the filter accumulates in 64 bits, as with a multiply-accumulate unit.
+template <int FRAC, class Storage, class Wide>
+struct SampleTraits<Fixed<FRAC, Storage, Wide>> {
+    typedef Fixed<FRAC, Storage, Wide> T;
+    typedef FixedComplex<T> complex_type;
+    typedef int64_t coeff_type;
+    typedef int64_t acc_type;
+    static const bool fixed = true;
+    static const int coeff_frac = 24;
+
+    static T fromDouble(double v) { return T::fromDouble(v); }
+    static double toDouble(T v) { return v.toDouble(); }
+    static coeff_type coeff(double c) { return (coeff_type) std::llround(std::ldexp(c, coeff_frac)); }
+    static acc_type mul(coeff_type c, T x) { return c * x.raw; }
+    static T fromAcc(acc_type a) {
+        int64_t v = (a + ((int64_t) 1 << (coeff_frac - 1))) >> coeff_frac;
+        v = std::min<int64_t>(std::max<int64_t>(v, std::numeric_limits<Storage>::min()), std::numeric_limits<Storage>::max());
+        return T::fromRaw((Wide) v);
+    }
+    static T magnitude(const complex_type &c) {
+        uint64_t re = (uint64_t) std::llabs((long long) c.re.raw);
+        uint64_t im = (uint64_t) std::llabs((long long) c.im.raw);
+        return T::fromRaw((Wide) std::min<uint64_t>(isqrt(re * re + im * im), (uint64_t) std::numeric_limits<Storage>::max()));
+    }
+};
+
+#endif // INCLUDED_FIXED_POINT_HH_
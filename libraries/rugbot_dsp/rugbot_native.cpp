@@ -0,0 +1,168 @@
+// C ABI over the rugbot_dsp kernels, see rugbot_native.h. Every function
+// checks its arguments and catches exceptions: nothing may unwind into C.
+
+#include <cmath>
+#include <complex>
+#include <new>
+
+#include "beta_belief.hh"
+#include "filtering.hh"
+#include "rugbot_native.h"
+#include "spectral_estimator.hh"
+
+static_assert(sizeof(Complex) == 2 * sizeof(double), "Complex must be two interleaved doubles");
+
+struct rugbot_spectral {
+    SpectralEstimator estimator;
+};
+
+static bool isPowerOfTwo(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+// Filter coefficients divided by a[0], as scipy.signal.lfilter does; the
+// kernels assume a[0] == 1
+struct Coefficients {
+    double b[MAX_IIR_TAPS];
+    double a[MAX_IIR_TAPS];
+};
+
+static bool normalise(const double *b, size_t n_b, const double *a, size_t n_a, Coefficients &c) {
+    if (b == nullptr || a == nullptr || n_b < 1 || n_b > MAX_IIR_TAPS || n_a < 1 || n_a > MAX_IIR_TAPS ||
+        a[0] == 0 || !std::isfinite(a[0])) {
+        return false;
+    }
+    for (size_t i = 0; i < n_b; ++i) {
+        c.b[i] = b[i] / a[0];
+    }
+    for (size_t i = 0; i < n_a; ++i) {
+        c.a[i] = a[i] / a[0];
+    }
+    return true;
+}
+
+int rugbot_native_abi_version(void) {
+    return RUGBOT_NATIVE_ABI_VERSION;
+}
+
+int rugbot_fft(double *data, size_t n) {
+    if (data == nullptr || !isPowerOfTwo(n)) return RUGBOT_EINVAL;
+    fftT<double>(reinterpret_cast<Complex*>(data), n);
+    return RUGBOT_OK;
+}
+
+int rugbot_abs_fft(const double *spectrum, size_t n, double *out) {
+    if (n > 0 && (spectrum == nullptr || out == nullptr)) return RUGBOT_EINVAL;
+    absFftT<double>(reinterpret_cast<const Complex*>(spectrum), n, out);
+    return RUGBOT_OK;
+}
+
+int rugbot_butter_lowpass(const double *x, size_t n, double cutoff_freq, double sampling_freq, double *out) {
+    if (n > 0 && (x == nullptr || out == nullptr)) return RUGBOT_EINVAL;
+    if (!(cutoff_freq > 0) || !(sampling_freq > 0)) return RUGBOT_EINVAL;
+    butterLowpassT<double>(x, n, cutoff_freq, sampling_freq, out);
+    return RUGBOT_OK;
+}
+
+int rugbot_forward_butterworth(const double *b, size_t n_b, const double *a, size_t n_a,
+                               const double *x, size_t n, double *out) {
+    Coefficients c;
+    if (!normalise(b, n_b, a, n_a, c) || (n > 0 && (x == nullptr || out == nullptr))) return RUGBOT_EINVAL;
+    forwardButterworthT<double>(c.b, n_b, c.a, n_a, x, n, out);
+    return RUGBOT_OK;
+}
+
+int rugbot_backward_butterworth(const double *b, size_t n_b, const double *a, size_t n_a,
+                                const double *x, size_t n, double *out) {
+    Coefficients c;
+    if (!normalise(b, n_b, a, n_a, c) || (n > 0 && (x == nullptr || out == nullptr))) return RUGBOT_EINVAL;
+    backwardButterworthT<double>(c.b, n_b, c.a, n_a, x, n, out);
+    return RUGBOT_OK;
+}
+
+size_t rugbot_find_peak(const double *magnitude, size_t n, size_t first, size_t last) {
+    if (magnitude == nullptr) return first;
+    return findPeakT<double>(magnitude, n, first, last);
+}
+
+void rugbot_beta_update(rugbot_beta *belief, int below, double learning_rate) {
+    if (belief == nullptr) return;
+    BetaBelief b{belief->alpha, belief->beta};
+    b.update(below != 0, learning_rate);
+    belief->alpha = b.alpha;
+    belief->beta = b.beta;
+}
+
+double rugbot_beta_mode(const rugbot_beta *belief) {
+    if (belief == nullptr) return 0;
+    return BetaBelief{belief->alpha, belief->beta}.mode();
+}
+
+double rugbot_beta_confidence(const rugbot_beta *belief, double center, double half_width) {
+    if (belief == nullptr) return 0;
+    return BetaBelief{belief->alpha, belief->beta}.confidence(center, half_width);
+}
+
+int rugbot_incomplete_beta(double a, double b, double x, double *out) {
+    if (out == nullptr || !(a > 0) || !(b > 0) || std::isnan(x)) return RUGBOT_EINVAL;
+    *out = incompleteBeta(a, b, x);
+    return RUGBOT_OK;
+}
+
+rugbot_spectral *rugbot_spectral_create(size_t block_size, double sample_freq, double min_freq, double max_freq) {
+    if (!isPowerOfTwo(block_size) || block_size < 4 || !(sample_freq > 0) || !(min_freq <= max_freq)) {
+        return nullptr;
+    }
+    try {
+        return new rugbot_spectral{SpectralEstimator(block_size, sample_freq, min_freq, max_freq)};
+    } catch (const std::exception &) {
+        return nullptr;
+    }
+}
+
+void rugbot_spectral_destroy(rugbot_spectral *estimator) {
+    delete estimator;
+}
+
+int rugbot_spectral_set_dwell(rugbot_spectral *estimator, size_t min_blocks, size_t max_blocks,
+                              double min_separation) {
+    if (estimator == nullptr || min_blocks < 1 || max_blocks < min_blocks) return RUGBOT_EINVAL;
+    estimator->estimator.min_blocks = min_blocks;
+    estimator->estimator.max_blocks = max_blocks;
+    estimator->estimator.min_separation = min_separation;
+    return RUGBOT_OK;
+}
+
+void rugbot_spectral_reset(rugbot_spectral *estimator) {
+    if (estimator != nullptr) estimator->estimator.reset();
+}
+
+size_t rugbot_spectral_add(rugbot_spectral *estimator, const double *samples, size_t n) {
+    if (estimator == nullptr || samples == nullptr) return 0;
+    SpectralEstimator &e = estimator->estimator;
+    size_t i = 0;
+    while (i < n && !e.done()) {
+        e.addSample(samples[i++]);
+    }
+    return i;
+}
+
+int rugbot_spectral_done(const rugbot_spectral *estimator) {
+    return estimator != nullptr && estimator->estimator.done();
+}
+
+size_t rugbot_spectral_blocks(const rugbot_spectral *estimator) {
+    return estimator != nullptr ? estimator->estimator.blocks() : 0;
+}
+
+double rugbot_spectral_peak_frequency(const rugbot_spectral *estimator) {
+    return estimator != nullptr ? estimator->estimator.peakFrequency() : 0;
+}
+
+double rugbot_spectral_peak_magnitude(const rugbot_spectral *estimator) {
+    return estimator != nullptr ? estimator->estimator.peakMagnitude() : 0;
+}
+
+double rugbot_spectral_separation(const rugbot_spectral *estimator) {
+    return estimator != nullptr ? estimator->estimator.separation() : 0;
+}
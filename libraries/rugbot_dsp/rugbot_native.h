@@ -0,0 +1,82 @@
+#ifndef RUGBOT_NATIVE_H_
+#define RUGBOT_NATIVE_H_
+
+/*
+ * C ABI of librugbot_native.so: the rugbot_dsp kernels the inspection
+ * controller runs, for the measurement scripts (measurements/rugbot_native.py)
+ * and any other language with a C FFI.
+ *
+ * All functions work on caller-provided buffers and never keep pointers to
+ * them. Complex values are interleaved (re, im) doubles, the layout of
+ * std::complex<double> and numpy complex128. Functions returning int return
+ * RUGBOT_OK or a negative RUGBOT_E* code. Symbols are versioned
+ * (RUGBOT_NATIVE_1); only additions are made within one version.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RUGBOT_NATIVE_ABI_VERSION 1
+
+#define RUGBOT_OK 0
+#define RUGBOT_EINVAL -1   /* bad size or NULL buffer */
+
+int rugbot_native_abi_version(void);
+
+/* In-place radix-2 FFT of n complex values, n a power of two */
+int rugbot_fft(double *data, size_t n);
+
+/* out[i] = |spectrum[i]| for n complex values */
+int rugbot_abs_fft(const double *spectrum, size_t n, double *out);
+
+/* First-order lowpass, out[0] = x[0] */
+int rugbot_butter_lowpass(const double *x, size_t n, double cutoff_freq, double sampling_freq, double *out);
+
+/* Butterworth filter (b, a as given by scipy.signal.butter, 1 to 16 taps
+ * each, normalised by a[0], the shorter one zero-padded as lfilter does)
+ * run forward or backward, as forwardButterworth/backwardButterworth */
+int rugbot_forward_butterworth(const double *b, size_t n_b, const double *a, size_t n_a,
+                               const double *x, size_t n, double *out);
+int rugbot_backward_butterworth(const double *b, size_t n_b, const double *a, size_t n_a,
+                                const double *x, size_t n, double *out);
+
+/* Index of the largest magnitude in [first, min(last, n)), first if empty */
+size_t rugbot_find_peak(const double *magnitude, size_t n, size_t first, size_t last);
+
+/* Beta belief, see beta_belief.hh; initialise with {2, 2} */
+typedef struct rugbot_beta {
+    double alpha;
+    double beta;
+} rugbot_beta;
+
+void rugbot_beta_update(rugbot_beta *belief, int below, double learning_rate);
+double rugbot_beta_mode(const rugbot_beta *belief);
+double rugbot_beta_confidence(const rugbot_beta *belief, double center, double half_width);
+/* *out = I_x(a, b); a and b must be positive */
+int rugbot_incomplete_beta(double a, double b, double x, double *out);
+
+/* Incremental spectral estimator, see spectral_estimator.hh */
+typedef struct rugbot_spectral rugbot_spectral;
+
+rugbot_spectral *rugbot_spectral_create(size_t block_size, double sample_freq, double min_freq, double max_freq);
+void rugbot_spectral_destroy(rugbot_spectral *estimator);
+int rugbot_spectral_set_dwell(rugbot_spectral *estimator, size_t min_blocks, size_t max_blocks,
+                              double min_separation);
+void rugbot_spectral_reset(rugbot_spectral *estimator);
+/* Feeds samples until the estimate is done or all n are used; returns the
+ * number of samples consumed */
+size_t rugbot_spectral_add(rugbot_spectral *estimator, const double *samples, size_t n);
+int rugbot_spectral_done(const rugbot_spectral *estimator);
+size_t rugbot_spectral_blocks(const rugbot_spectral *estimator);
+double rugbot_spectral_peak_frequency(const rugbot_spectral *estimator);
+double rugbot_spectral_peak_magnitude(const rugbot_spectral *estimator);
+double rugbot_spectral_separation(const rugbot_spectral *estimator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RUGBOT_NATIVE_H_ */
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+
+#include "beta_belief.hh"
+#include "spectral_estimator.hh"
+
+SpectralEstimator::SpectralEstimator(std::size_t block_size, double sample_freq, double min_freq, double max_freq)
+    : block_size(block_size), sample_freq(sample_freq), window(block_size), samples(block_size), work(block_size),
+      mean(block_size / 2 + 1), m2(block_size / 2 + 1) {
+    const double bin_width = sample_freq / block_size;
+    first_bin = std::max<std::size_t>(1, (std::size_t) std::ceil(min_freq / bin_width));
+    last_bin = std::min(block_size / 2, (std::size_t) std::floor(max_freq / bin_width));
+    last_bin = std::max(last_bin, first_bin);
+
+    // Periodic Hann window
+    for (std::size_t i = 0; i < block_size; ++i) {
+        window[i] = 0.5 - 0.5 * std::cos(2 * PI * i / block_size);
+        window_sum += window[i];
+    }
+    reset();
+}
+
+void SpectralEstimator::reset() {
+    filled = 0;
+    n_blocks = 0;
+    peak = first_bin;
+    runner_up = first_bin;
+    std::fill(mean.begin(), mean.end(), 0.0);
+    std::fill(m2.begin(), m2.end(), 0.0);
+}
+
+bool SpectralEstimator::addSample(double x) {
+    samples[filled++] = x;
+    if (filled < block_size) {
+        return false;
+    }
+    addBlock();
+    filled = 0;
+    return true;
+}
+
+void SpectralEstimator::addBlock() {
+    double dc = 0;
+    for (double v : samples) {
+        dc += v;
+    }
+    dc /= block_size;
+    for (std::size_t i = 0; i < block_size; ++i) {
+        work[i] = Complex((samples[i] - dc) * window[i], 0.0);
+    }
+    fft(work);
+
+    ++n_blocks;
+    for (std::size_t k = first_bin; k <= last_bin; ++k) {
+        double power = std::norm(work[k]);
+        double delta = power - mean[k];
+        mean[k] += delta / n_blocks;
+        m2[k] += delta * (power - mean[k]);
+    }
+
+    peak = first_bin;
+    for (std::size_t k = first_bin + 1; k <= last_bin; ++k) {
+        if (mean[k] > mean[peak]) {
+            peak = k;
+        }
+    }
+    // The Hann main lobe is two bins wide on either side
+    runner_up = peak;
+    for (std::size_t k = first_bin; k <= last_bin; ++k) {
+        if ((k + 2 < peak || k > peak + 2) && (runner_up == peak || mean[k] > mean[runner_up])) {
+            runner_up = k;
+        }
+    }
+}
+
+bool SpectralEstimator::done() const {
+    return n_blocks >= max_blocks || (n_blocks >= min_blocks && separation() >= criticalSeparation());
+}
+
+// Upper tail probability of Student's t with df degrees of freedom, t >= 0
+static double studentTail(double t, double df) {
+    return 0.5 * incompleteBeta(df / 2, 0.5, df / (df + t * t));
+}
+
+double SpectralEstimator::criticalSeparation() const {
+    if (n_blocks < 2) {
+        return INFINITY;
+    }
+    if (n_blocks == critical_blocks && min_separation == critical_for) {
+        return critical;
+    }
+    // Bracket and bisect the t quantile with the tail of min_separation
+    const double df = (double) (n_blocks - 1);
+    const double tail = 0.5 * std::erfc(min_separation / std::sqrt(2.0));
+    double low = 0;
+    double high = std::max(min_separation, 1.0);
+    while (studentTail(high, df) > tail && high < 1e12) {
+        low = high;
+        high *= 2;
+    }
+    for (int i = 0; i < 60; ++i) {
+        double middle = 0.5 * (low + high);
+        (studentTail(middle, df) > tail ? low : high) = middle;
+    }
+    critical = high;
+    critical_for = min_separation;
+    critical_blocks = n_blocks;
+    return critical;
+}
+
+double SpectralEstimator::peakFrequency() const {
+    double offset = 0;
+    if (peak > first_bin && peak < last_bin) {
+        double a = std::sqrt(mean[peak - 1]);
+        double b = std::sqrt(mean[peak]);
+        double c = std::sqrt(mean[peak + 1]);
+        double denominator = a - 2 * b + c;
+        if (denominator < 0) {
+            offset = std::clamp(0.5 * (a - c) / denominator, -0.5, 0.5);
+        }
+    }
+    return (peak + offset) * sample_freq / block_size;
+}
+
+double SpectralEstimator::peakMagnitude() const {
+    return 2 * std::sqrt(mean[peak]) / window_sum;
+}
+
+double SpectralEstimator::separation() const {
+    if (n_blocks < 2) {
+        return 0;
+    }
+    if (runner_up == peak) {
+        return INFINITY;
+    }
+    double difference = mean[peak] - mean[runner_up];
+    double variance = (m2[peak] + m2[runner_up]) / (n_blocks - 1);
+    double error = std::sqrt(variance / n_blocks);
+    if (error == 0) {
+        return difference > 0 ? INFINITY : 0;
+    }
+    return difference / error;
+}
@@ -0,0 +1,94 @@
+#ifndef INCLUDED_SPECTRAL_ESTIMATOR_HH_
+#define INCLUDED_SPECTRAL_ESTIMATOR_HH_
+
+#include <cmath>
+#include <cstddef>
+
+#include "filtering.hh"
+
+// Incremental estimate of the dominant vibration frequency of a cell, refined
+// with every block of samples so an observation can stop as soon as the peak
+// is unambiguous and only runs long for ambiguous cells.
+//
+// Each block of block_size samples is detrended, Hann windowed and
+// transformed; the power of every bin in [min_freq, max_freq] is added to a
+// running mean and variance (Welford), i.e. a Welch PSD estimate without
+// overlap. The peak is the bin with the largest mean power. Its separation
+// is the t statistic of the difference between the peak and the strongest
+// bin outside the peak's main lobe, the confidence measure used by done().
+// No method allocates after construction.
+class SpectralEstimator {
+public:
+    SpectralEstimator(std::size_t block_size, double sample_freq, double min_freq, double max_freq);
+
+    // Length limits of an observation, in blocks, and the confidence that
+    // ends it before max_blocks, as a normal quantile. done() compares the
+    // separation with the Student's t quantile of the same tail probability
+    // for blocks() - 1 degrees of freedom, so few blocks need far more.
+    std::size_t min_blocks = 3;
+    std::size_t max_blocks = 8;
+    double min_separation = 3.0;
+
+    void reset();
+    // Adds one sample, returns true when it completed a block
+    bool addSample(double x);
+    // At least min_blocks and a clear peak, or max_blocks reached
+    bool done() const;
+
+    std::size_t blocks() const { return n_blocks; }
+    std::size_t peakBin() const { return peak; }
+    // Peak frequency in Hz, interpolated between bins
+    double peakFrequency() const;
+    // Amplitude of a sine at the peak frequency
+    double peakMagnitude() const;
+    // 0 before two blocks, infinite when nothing competes with the peak
+    double separation() const;
+    // Separation at which done() stops early with the current blocks()
+    double criticalSeparation() const;
+
+    template <class Archive> void checkpoint(Archive &ar);
+
+private:
+    std::size_t block_size;
+    double sample_freq;
+    std::size_t first_bin;
+    std::size_t last_bin;
+    double window_sum = 0;
+    Array window;
+    Array samples;
+    CArray work;
+    Array mean;
+    Array m2;
+    std::size_t filled = 0;
+    std::size_t n_blocks = 0;
+    std::size_t peak = 0;
+    std::size_t runner_up = 0;
+    // Last result of criticalSeparation() and its arguments
+    mutable double critical = INFINITY;
+    mutable double critical_for = NAN;
+    mutable std::size_t critical_blocks = 0;
+
+    void addBlock();
+};
+
+template <class Archive>
+void SpectralEstimator::checkpoint(Archive &ar) {
+    ar.field("spectral_filled", filled);
+    ar.field("spectral_blocks", n_blocks);
+    ar.field("spectral_peak", peak);
+    ar.field("spectral_runner_up", runner_up);
+    ar.field("spectral_samples", samples);
+    ar.field("spectral_mean", mean);
+    ar.field("spectral_m2", m2);
+    // An estimate saved with another block size starts over
+    if (ar.restoring() && (samples.size() != block_size || mean.size() != block_size / 2 + 1 ||
+                           m2.size() != mean.size() || filled >= block_size || peak >= mean.size() ||
+                           runner_up >= mean.size())) {
+        samples.assign(block_size, 0.0);
+        mean.assign(block_size / 2 + 1, 0.0);
+        m2.assign(block_size / 2 + 1, 0.0);
+        reset();
+    }
+}
+
+#endif // INCLUDED_SPECTRAL_ESTIMATOR_HH_
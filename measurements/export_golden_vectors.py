@@ -0,0 +1,75 @@
+import os
+import numpy as np
+from scipy.signal import butter, lfilter, lfiltic
+
+# Export reference outputs of the DSP kernels in libraries/rugbot_dsp so the
+# C++ benchmark (dsp_bench) can check its accuracy against numpy/scipy.
+# Run from the repository root: python3 measurements/export_golden_vectors.py
+
+out_dir = "measurements/golden"
+os.makedirs(out_dir, exist_ok=True)
+
+# Same filter as test.py
+order = 2
+fs = 200.0
+cutoff_freq = 15.0
+b, a = butter(order, cutoff_freq / (fs / 2), btype='low', analog=False)
+
+# Parameters of butter_lowpass_filter
+lp_cutoff = 10.0
+lp_fs = 50.0
+
+
+def write_vector(name, values):
+    with open(f"{out_dir}/{name}", 'w') as file:
+        for number in values:
+            file.write(f"{number:.18e}\n")
+
+
+def lowpass(x):
+    # y[0] = x[0], y[i] = alpha * x[i] + (1 - alpha) * y[i - 1]
+    rc = 1.0 / (lp_cutoff * 2 * np.pi)
+    dt = 1.0 / lp_fs
+    alpha = dt / (rc + dt)
+    y, _ = lfilter([alpha], [1.0, alpha - 1.0], x, zi=[(1.0 - alpha) * x[0]])
+    return y
+
+
+def iir_from(b, a, x, start):
+    # scipy.signal.lfilter started at sample `start`, with the outputs before
+    # it held at zero and the inputs before it as the filter's history
+    y = np.zeros_like(x)
+    history = x[start - 1::-1][:len(b) - 1]
+    zi = lfiltic(b, a, np.zeros(len(a) - 1), history)
+    y[start:], _ = lfilter(b, a, x[start:], zi=zi)
+    return y
+
+
+def forward(b, a, x):
+    # Outputs before len(b) are left at zero, as on the robot
+    return iir_from(b, a, x, len(b))
+
+
+def backward(b, a, x):
+    # The same filter run from the end of the signal, the last len(b) - 1
+    # outputs left at zero
+    return iir_from(b, a, x[::-1], len(b) - 1)[::-1]
+
+
+write_vector("butter_b.txt", b)
+write_vector("butter_a.txt", a)
+
+rng = np.random.default_rng(5)
+for n in [64, 1024]:
+    t = np.arange(n) / fs
+    # Two vibration modes plus sensor noise
+    x = 0.8 * np.sin(2 * np.pi * 12.5 * t) + 0.3 * np.sin(2 * np.pi * 41.0 * t) + rng.normal(0, 0.1, n)
+    mag = np.abs(np.fft.fft(x))
+
+    write_vector(f"input_{n}.txt", x)
+    write_vector(f"abs_fft_{n}.txt", mag)
+    write_vector(f"lowpass_{n}.txt", lowpass(x))
+    fw = forward(b, a, mag)
+    write_vector(f"forward_{n}.txt", fw)
+    write_vector(f"backward_{n}.txt", backward(b, a, fw))
+    print(f"exported golden vectors for n = {n}")
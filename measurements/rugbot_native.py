@@ -0,0 +1,288 @@
+import ctypes
+import os
+
+import numpy as np
+
+# numpy front end of librugbot_native.so, the C ABI of the controller's DSP
+# kernels (libraries/rugbot_dsp/rugbot_native.h). Arrays are passed to C
+# without copying when they are already contiguous float64 / complex128.
+# Build the library with `make` in libraries/rugbot_dsp, or point
+# RUGBOT_NATIVE_LIB at it. Run this file to check it against numpy/scipy.
+
+ABI_VERSION = 1
+
+_here = os.path.dirname(os.path.abspath(__file__))
+_path = os.environ.get("RUGBOT_NATIVE_LIB",
+                       os.path.join(_here, "..", "libraries", "rugbot_dsp", "librugbot_native.so"))
+_lib = ctypes.CDLL(_path)
+
+_double_p = ctypes.POINTER(ctypes.c_double)
+_size = ctypes.c_size_t
+
+
+class BetaState(ctypes.Structure):
+    _fields_ = [("alpha", ctypes.c_double), ("beta", ctypes.c_double)]
+
+
+def _declare(name, restype, *argtypes):
+    function = getattr(_lib, name)
+    function.restype = restype
+    function.argtypes = argtypes
+    return function
+
+
+_declare("rugbot_native_abi_version", ctypes.c_int)
+_declare("rugbot_fft", ctypes.c_int, _double_p, _size)
+_declare("rugbot_abs_fft", ctypes.c_int, _double_p, _size, _double_p)
+_declare("rugbot_butter_lowpass", ctypes.c_int, _double_p, _size, ctypes.c_double, ctypes.c_double, _double_p)
+for _name in ("rugbot_forward_butterworth", "rugbot_backward_butterworth"):
+    _declare(_name, ctypes.c_int, _double_p, _size, _double_p, _size, _double_p, _size, _double_p)
+_declare("rugbot_find_peak", _size, _double_p, _size, _size, _size)
+_declare("rugbot_beta_update", None, ctypes.POINTER(BetaState), ctypes.c_int, ctypes.c_double)
+_declare("rugbot_beta_mode", ctypes.c_double, ctypes.POINTER(BetaState))
+_declare("rugbot_beta_confidence", ctypes.c_double, ctypes.POINTER(BetaState), ctypes.c_double, ctypes.c_double)
+_declare("rugbot_incomplete_beta", ctypes.c_int, ctypes.c_double, ctypes.c_double, ctypes.c_double, _double_p)
+_declare("rugbot_spectral_create", ctypes.c_void_p, _size, ctypes.c_double, ctypes.c_double, ctypes.c_double)
+_declare("rugbot_spectral_destroy", None, ctypes.c_void_p)
+_declare("rugbot_spectral_set_dwell", ctypes.c_int, ctypes.c_void_p, _size, _size, ctypes.c_double)
+_declare("rugbot_spectral_reset", None, ctypes.c_void_p)
+_declare("rugbot_spectral_add", _size, ctypes.c_void_p, _double_p, _size)
+_declare("rugbot_spectral_done", ctypes.c_int, ctypes.c_void_p)
+_declare("rugbot_spectral_blocks", _size, ctypes.c_void_p)
+for _name in ("rugbot_spectral_peak_frequency", "rugbot_spectral_peak_magnitude", "rugbot_spectral_separation"):
+    _declare(_name, ctypes.c_double, ctypes.c_void_p)
+
+if _lib.rugbot_native_abi_version() != ABI_VERSION:
+    raise ImportError(f"{_path} has ABI version {_lib.rugbot_native_abi_version()}, expected {ABI_VERSION}")
+
+
+def _pointer(array):
+    return array.ctypes.data_as(_double_p)
+
+
+def _output(out, n):
+    if out is None:
+        return np.empty(n)
+    if out.dtype != np.float64 or not out.flags.c_contiguous or out.size != n:
+        raise ValueError(f"out must be a contiguous float64 array of {n} values")
+    return out
+
+
+def _check(status, name):
+    if status != 0:
+        raise ValueError(f"{name} rejected its arguments ({status})")
+
+
+def fft(x, inplace=False):
+    """FFT of a power-of-two number of samples. With inplace=True a contiguous
+    complex128 array is transformed in place and returned."""
+    if inplace:
+        data = x
+        if data.dtype != np.complex128 or not data.flags.c_contiguous:
+            raise ValueError("inplace fft needs a contiguous complex128 array")
+    else:
+        data = np.array(x, dtype=np.complex128, order='C')
+    _check(_lib.rugbot_fft(_pointer(data), data.size), "rugbot_fft")
+    return data
+
+
+def abs_fft(spectrum, out=None):
+    spectrum = np.ascontiguousarray(spectrum, dtype=np.complex128)
+    out = _output(out, spectrum.size)
+    _check(_lib.rugbot_abs_fft(_pointer(spectrum), spectrum.size, _pointer(out)), "rugbot_abs_fft")
+    return out
+
+
+def butter_lowpass(x, cutoff_freq, sampling_freq, out=None):
+    x = np.ascontiguousarray(x, dtype=np.float64)
+    out = _output(out, x.size)
+    _check(_lib.rugbot_butter_lowpass(_pointer(x), x.size, cutoff_freq, sampling_freq, _pointer(out)),
+           "rugbot_butter_lowpass")
+    return out
+
+
+def _butterworth(function, b, a, x, out):
+    b = np.ascontiguousarray(b, dtype=np.float64)
+    a = np.ascontiguousarray(a, dtype=np.float64)
+    x = np.ascontiguousarray(x, dtype=np.float64)
+    out = _output(out, x.size)
+    _check(function(_pointer(b), b.size, _pointer(a), a.size, _pointer(x), x.size, _pointer(out)), function.__name__)
+    return out
+
+
+def forward_butterworth(b, a, x, out=None):
+    return _butterworth(_lib.rugbot_forward_butterworth, b, a, x, out)
+
+
+def backward_butterworth(b, a, x, out=None):
+    return _butterworth(_lib.rugbot_backward_butterworth, b, a, x, out)
+
+
+def find_peak(magnitude, first=0, last=None):
+    magnitude = np.ascontiguousarray(magnitude, dtype=np.float64)
+    last = magnitude.size if last is None else last
+    return _lib.rugbot_find_peak(_pointer(magnitude), magnitude.size, first, last)
+
+
+def incomplete_beta(a, b, x):
+    """Regularized incomplete beta function I_x(a, b) for a, b > 0."""
+    out = ctypes.c_double()
+    _check(_lib.rugbot_incomplete_beta(a, b, x, ctypes.byref(out)), "rugbot_incomplete_beta")
+    return out.value
+
+
+class BetaBelief:
+    """Beta belief updated as in beta_dist_test.py."""
+
+    def __init__(self, alpha=2.0, beta=2.0):
+        self.state = BetaState(alpha, beta)
+
+    @property
+    def alpha(self):
+        return self.state.alpha
+
+    @property
+    def beta(self):
+        return self.state.beta
+
+    def update(self, below, learning_rate):
+        _lib.rugbot_beta_update(ctypes.byref(self.state), int(bool(below)), learning_rate)
+
+    def mode(self):
+        return _lib.rugbot_beta_mode(ctypes.byref(self.state))
+
+    def confidence(self, center, half_width):
+        return _lib.rugbot_beta_confidence(ctypes.byref(self.state), center, half_width)
+
+
+class SpectralEstimator:
+    """Incremental peak frequency estimate of the inspection controller."""
+
+    def __init__(self, block_size, sample_freq, min_freq, max_freq):
+        self.handle = _lib.rugbot_spectral_create(block_size, sample_freq, min_freq, max_freq)
+        if not self.handle:
+            raise ValueError("rugbot_spectral_create rejected its arguments")
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            _lib.rugbot_spectral_destroy(self.handle)
+            self.handle = None
+
+    def set_dwell(self, min_blocks, max_blocks, min_separation):
+        _check(_lib.rugbot_spectral_set_dwell(self.handle, min_blocks, max_blocks, min_separation),
+               "rugbot_spectral_set_dwell")
+
+    def reset(self):
+        _lib.rugbot_spectral_reset(self.handle)
+
+    def add(self, samples):
+        """Feed samples until the estimate is done; returns how many were used."""
+        samples = np.ascontiguousarray(samples, dtype=np.float64)
+        return _lib.rugbot_spectral_add(self.handle, _pointer(samples), samples.size)
+
+    @property
+    def done(self):
+        return bool(_lib.rugbot_spectral_done(self.handle))
+
+    @property
+    def blocks(self):
+        return _lib.rugbot_spectral_blocks(self.handle)
+
+    @property
+    def peak_frequency(self):
+        return _lib.rugbot_spectral_peak_frequency(self.handle)
+
+    @property
+    def peak_magnitude(self):
+        return _lib.rugbot_spectral_peak_magnitude(self.handle)
+
+    @property
+    def separation(self):
+        return _lib.rugbot_spectral_separation(self.handle)
+
+
+if __name__ == '__main__':
+    from scipy.signal import lfilter, lfiltic
+    from scipy.special import betainc
+
+    golden = os.path.join(_here, "golden")
+
+    def load(name):
+        return np.loadtxt(os.path.join(golden, name))
+
+    def report(name, result, expected):
+        error = np.max(np.abs(result - expected)) / max(np.max(np.abs(expected)), 1e-300)
+        print(f"{name:<22} rel. error {error:.3e}  {'OK' if error < 1e-9 else 'FAIL'}")
+        return error < 1e-9
+
+    b, a = load("butter_b.txt"), load("butter_a.txt")
+    ok = True
+    for n in (64, 1024):
+        x = load(f"input_{n}.txt")
+        spectrum = fft(x)
+        ok &= report(f"fft {n}", spectrum, np.fft.fft(x))
+        magnitude = abs_fft(spectrum)
+        ok &= report(f"abs_fft {n}", magnitude, load(f"abs_fft_{n}.txt"))
+        ok &= report(f"butter_lowpass {n}", butter_lowpass(x, 10.0, 50.0), load(f"lowpass_{n}.txt"))
+        # Filtered as in export_golden_vectors.py: magnitude, forward, backward
+        forward = forward_butterworth(b, a, magnitude)
+        ok &= report(f"forward {n}", forward, load(f"forward_{n}.txt"))
+        ok &= report(f"backward {n}", backward_butterworth(b, a, forward), load(f"backward_{n}.txt"))
+
+    # Coefficients are normalised by a[0] as lfilter does; empty b is rejected
+    x = load("input_64.txt")
+    ok &= report("forward a[0] = 2", forward_butterworth(2 * b, 2 * a, x), forward_butterworth(b, a, x))
+
+    # b and a of different lengths are zero-padded to the longer one, as
+    # lfilter does; the outputs before that many taps are left at zero
+    def started_lfilter(b_, a_, x_, start):
+        taps = max(len(b_), len(a_))
+        b_, a_ = np.pad(b_, (0, taps - len(b_))), np.pad(a_, (0, taps - len(a_)))
+        y = np.zeros_like(x_)
+        zi = lfiltic(b_, a_, np.zeros(taps - 1), x_[start - 1::-1][:taps - 1])
+        y[start:], _ = lfilter(b_, a_, x_[start:], zi=zi)
+        return y
+
+    for b_, a_ in (([1.0], [1.0, -0.5]), ([0.5, 0.5], [1.0])):
+        taps = max(len(b_), len(a_))
+        ok &= report(f"forward {len(b_)}/{len(a_)} taps", forward_butterworth(b_, a_, x),
+                     started_lfilter(b_, a_, x, taps))
+        ok &= report(f"backward {len(b_)}/{len(a_)} taps", backward_butterworth(b_, a_, x),
+                     started_lfilter(b_, a_, x[::-1], taps - 1)[::-1])
+
+    def rejects(function, *args):
+        try:
+            function(*args)
+        except ValueError:
+            return True
+        print(f"{function.__name__}{args[:2]} was not rejected  FAIL")
+        return False
+
+    ok &= rejects(forward_butterworth, np.empty(0), a, x)
+    ok &= rejects(backward_butterworth, np.empty(0), a, x)
+    ok &= rejects(incomplete_beta, 0.0, 1.0, 0.5)
+    ok &= rejects(incomplete_beta, 2.0, -1.0, 0.5)
+
+    in_place = np.ascontiguousarray(load("input_64.txt"), dtype=np.complex128)
+    address = in_place.ctypes.data
+    fft(in_place, inplace=True)
+    ok &= report("fft in place", in_place, np.fft.fft(load("input_64.txt"))) and in_place.ctypes.data == address
+
+    grid = [(a_, b_, x_) for a_ in (0.5, 2.0, 37.5) for b_ in (1.0, 2.0, 120.0) for x_ in (0.01, 0.3, 0.5, 0.97)]
+    ok &= report("incomplete_beta", np.array([incomplete_beta(*p) for p in grid]),
+                 np.array([betainc(*p) for p in grid]))
+
+    belief = BetaBelief()
+    for below in (False, False, True, False):
+        belief.update(below, 10.0)
+    ok &= report("beta confidence", np.array([belief.confidence(0.6, 0.05)]),
+                 np.array([betainc(belief.alpha, belief.beta, 0.65) - betainc(belief.alpha, belief.beta, 0.55)]))
+
+    estimator = SpectralEstimator(64, 1000.0 / 32, 1.0, 24.0)
+    t = np.arange(1024) / (1000.0 / 32)
+    used = estimator.add(np.sin(2 * np.pi * 7.0 * t))
+    print(f"spectral estimator     {estimator.peak_frequency:.2f} Hz after {used} samples")
+    ok &= abs(estimator.peak_frequency - 7.0) < 0.2 and estimator.done
+
+    print("OK" if ok else "FAILED")
+    raise SystemExit(0 if ok else 1)
@@ -0,0 +1,125 @@
+#ifndef INCLUDED_LINE_SCAN_HH_
+#define INCLUDED_LINE_SCAN_HH_
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Read-only memory map of a whole file. text() is empty for a missing or
+// empty file.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isOpen() const { return found; }
+    std::string_view text() const { return std::string_view(data, size); }
+
+private:
+    const char *data = nullptr;
+    std::size_t size = 0;
+    bool found = false;
+};
+
+inline MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    found = true;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(nullptr, (std::size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = static_cast<const char*>(p);
+            size = (std::size_t) st.st_size;
+            madvise(p, size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+}
+
+inline MappedFile::~MappedFile() {
+    if (data != nullptr) {
+        munmap(const_cast<char*>(data), size);
+    }
+}
+
+// First '\n' in [p, end), or end. Compares 16 bytes at a time with SSE2 and
+// falls back to memchr for the tail and on other targets.
+inline const char *findNewline(const char *p, const char *end) {
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return p + __builtin_ctz((unsigned) mask);
+        }
+    }
+#endif
+    const void *found = std::memchr(p, '\n', (std::size_t) (end - p));
+    return found != nullptr ? static_cast<const char*>(found) : end;
+}
+
+// Calls f(line) for every line, without its line ending.
+template <class F>
+void forEachLine(std::string_view text, F f) {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    while (p < end) {
+        const char *newline = findNewline(p, end);
+        const char *last = newline;
+        if (last > p && last[-1] == '\r') {
+            --last;
+        }
+        f(std::string_view(p, (std::size_t) (last - p)));
+        p = newline + 1;
+    }
+}
+
+// Calls f(value) for every number in a line of comma or whitespace separated
+// values; other tokens are skipped.
+template <class F>
+void forEachNumber(std::string_view line, F f) {
+    const char *p = line.data();
+    const char *end = p + line.size();
+    while (p < end) {
+        while (p < end && (*p == ',' || *p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        if (p == end) {
+            break;
+        }
+        double value;
+        std::from_chars_result r = std::from_chars(p, end, value);
+        if (r.ec == std::errc() && (r.ptr == end || *r.ptr == ',' || *r.ptr == ' ' || *r.ptr == '\t')) {
+            f(value);
+            p = r.ptr;
+        } else {
+            while (p < end && *p != ',' && *p != ' ' && *p != '\t') {
+                ++p;
+            }
+        }
+    }
+}
+
+inline bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+#endif // INCLUDED_LINE_SCAN_HH_
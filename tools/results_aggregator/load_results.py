@@ -0,0 +1,28 @@
+import struct
+import sys
+
+import numpy as np
+
+
+def load_results(path):
+    """Read results.rbcol written by results_aggregator into a dict of numpy columns."""
+    with open(path, 'rb') as file:
+        data = file.read()
+    magic, version, rows, n_columns = struct.unpack_from('<4sIQI', data, 0)
+    if magic != b'RBCO' or version != 1:
+        raise ValueError(f"{path} is not a results_aggregator dataset")
+    offset = 20
+    names = []
+    for _ in range(n_columns):
+        (length,) = struct.unpack_from('<I', data, offset)
+        names.append(data[offset + 4:offset + 4 + length].decode())
+        offset += 4 + length
+    offset += (8 - offset % 8) % 8
+    values = np.frombuffer(data, dtype='<f8', count=rows * n_columns, offset=offset).reshape(n_columns, rows)
+    return dict(zip(names, values))
+
+
+if __name__ == '__main__':
+    columns = load_results(sys.argv[1] if len(sys.argv) > 1 else 'results.rbcol')
+    for name, column in columns.items():
+        print(f"{name:>12}: {column}")
@@ -0,0 +1,305 @@
+// File:          results_aggregator.cpp
+// Description:   Collects the results of a parameter sweep into one dataset.
+//                Scans jobfiles/Run_*/Instance_*/ in parallel, memory-maps
+//                the Webots logs, settings and output files of every
+//                instance and joins them into one row per instance with its
+//                c_settings and s_settings values. Writes
+//                  results.rbcol     columnar table, one row per instance
+//                                    (load_results.py reads it into numpy)
+//                  run_summary.csv   summary statistics per run
+//
+// Usage:         ./results_aggregator [-j threads] [-o output dir] [jobfiles or Run_* dir ...]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "line_scan.hh"
+
+namespace fs = std::filesystem;
+
+// Running count, mean, variance (Welford) and range
+struct Stats {
+    uint64_t n = 0;
+    double mean = 0;
+    double m2 = 0;
+    double min = NAN;
+    double max = NAN;
+
+    void add(double v) {
+        ++n;
+        double delta = v - mean;
+        mean += delta / n;
+        m2 += delta * (v - mean);
+        min = n == 1 ? v : std::min(min, v);
+        max = n == 1 ? v : std::max(max, v);
+    }
+    // Chan et al. parallel combination
+    void merge(const Stats &o) {
+        if (o.n == 0) return;
+        if (n == 0) {
+            *this = o;
+            return;
+        }
+        uint64_t total = n + o.n;
+        double delta = o.mean - mean;
+        mean += delta * o.n / total;
+        m2 += o.m2 + delta * delta * ((double) n * o.n / total);
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        n = total;
+    }
+    double stddev() const { return n > 1 ? std::sqrt(m2 / (n - 1)) : NAN; }
+    double meanOrNan() const { return n > 0 ? mean : NAN; }
+};
+
+struct Instance {
+    int run = 0;
+    int instance = 0;
+    fs::path dir;
+
+    uint64_t bytes = 0;
+    uint64_t log_lines = 0;
+    uint64_t log_info = 0;
+    uint64_t log_warning = 0;
+    uint64_t log_error = 0;
+    uint64_t robot_controllers = 0;  // inspection controllers Webots started
+    Stats freq;                 // peak frequencies, freq_mag_output*.txt
+    uint64_t data_rows = 0;     // data_rov.txt
+    std::vector<double> c_settings;
+    std::vector<double> s_settings;
+};
+
+// Number after the last '_' of a directory name such as Run_12
+static int dirNumber(const fs::path &dir) {
+    std::string name = dir.filename().string();
+    return atoi(name.c_str() + name.rfind('_') + 1);
+}
+
+static void findInstances(const fs::path &run, std::vector<Instance> &instances) {
+    std::error_code ec;
+    for (const fs::directory_entry &entry : fs::directory_iterator(run, ec)) {
+        if (entry.is_directory() && startsWith(entry.path().filename().string(), "Instance_")) {
+            Instance instance;
+            instance.run = dirNumber(run);
+            instance.instance = dirNumber(entry.path());
+            instance.dir = entry.path();
+            instances.push_back(std::move(instance));
+        }
+    }
+}
+
+static void readLog(std::string_view text, Instance &r) {
+    forEachLine(text, [&](std::string_view line) {
+        ++r.log_lines;
+        if (startsWith(line, "INFO:")) {
+            ++r.log_info;
+            // The supervisor is started the same way, so only count the robots
+            if (startsWith(line, "INFO: inspection_controller: Starting controller")) {
+                ++r.robot_controllers;
+            }
+        } else if (startsWith(line, "WARNING:")) {
+            ++r.log_warning;
+        } else if (startsWith(line, "ERROR:")) {
+            ++r.log_error;
+        }
+    });
+}
+
+static void readValues(std::string_view text, std::vector<double> &values) {
+    forEachLine(text, [&](std::string_view line) {
+        forEachNumber(line, [&](double v) { values.push_back(v); });
+    });
+}
+
+static void aggregate(Instance &r) {
+    std::error_code ec;
+    for (const fs::directory_entry &entry : fs::directory_iterator(r.dir, ec)) {
+        if (!entry.is_regular_file()) continue;
+        const std::string name = entry.path().filename().string();
+        const bool log = startsWith(name, "webots_log_");
+        const bool freq = startsWith(name, "freq_mag_output");
+        const bool data = name == "data_rov.txt";
+        const bool c = name == "c_settings.txt";
+        const bool s = name == "s_settings.txt";
+        if (!(log || freq || data || c || s)) continue;
+
+        MappedFile file(entry.path().string());
+        std::string_view text = file.text();
+        r.bytes += text.size();
+        if (log) {
+            readLog(text, r);
+        } else if (freq) {
+            // frequency, magnitude pairs: every other value is a frequency
+            forEachLine(text, [&](std::string_view line) {
+                std::size_t i = 0;
+                forEachNumber(line, [&](double v) {
+                    if (i++ % 2 == 0) r.freq.add(v);
+                });
+            });
+        } else if (data) {
+            forEachLine(text, [&](std::string_view line) { r.data_rows += !line.empty(); });
+        } else {
+            readValues(text, c ? r.c_settings : r.s_settings);
+        }
+    }
+}
+
+// results.rbcol: "RBCO", uint32 version, uint64 rows, uint32 columns, then
+// per column a uint32 name length and the name, zero padding to a multiple
+// of 8 bytes, and the columns one after another as rows float64 values.
+// Little endian; missing values are NaN.
+static bool writeColumns(const fs::path &path, const std::vector<Instance> &instances) {
+    std::size_t n_c = 0, n_s = 0;
+    for (const Instance &r : instances) {
+        n_c = std::max(n_c, r.c_settings.size());
+        n_s = std::max(n_s, r.s_settings.size());
+    }
+    std::vector<std::string> names = {"run", "instance", "log_lines", "log_info", "log_warning", "log_error",
+                                      "robot_controllers", "freq_count", "freq_mean", "freq_std", "freq_min",
+                                      "freq_max", "data_rows"};
+    const std::size_t fixed = names.size();
+    for (std::size_t i = 0; i < n_c; ++i) names.push_back("c" + std::to_string(i));
+    for (std::size_t i = 0; i < n_s; ++i) names.push_back("s" + std::to_string(i));
+
+    const uint64_t rows = instances.size();
+    std::vector<double> columns(names.size() * rows, NAN);
+    for (std::size_t row = 0; row < rows; ++row) {
+        const Instance &r = instances[row];
+        const double values[] = {(double) r.run, (double) r.instance, (double) r.log_lines, (double) r.log_info,
+                                 (double) r.log_warning, (double) r.log_error, (double) r.robot_controllers,
+                                 (double) r.freq.n, r.freq.meanOrNan(), r.freq.stddev(), r.freq.min, r.freq.max,
+                                 (double) r.data_rows};
+        for (std::size_t col = 0; col < fixed; ++col) {
+            columns[col * rows + row] = values[col];
+        }
+        for (std::size_t i = 0; i < r.c_settings.size(); ++i) {
+            columns[(fixed + i) * rows + row] = r.c_settings[i];
+        }
+        for (std::size_t i = 0; i < r.s_settings.size(); ++i) {
+            columns[(fixed + n_c + i) * rows + row] = r.s_settings[i];
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    const uint32_t version = 1;
+    const uint32_t n_columns = (uint32_t) names.size();
+    out.write("RBCO", 4);
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    out.write(reinterpret_cast<const char*>(&n_columns), sizeof(n_columns));
+    std::size_t offset = 20;
+    for (const std::string &name : names) {
+        uint32_t length = (uint32_t) name.size();
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(name.data(), length);
+        offset += sizeof(length) + length;
+    }
+    const char padding[8] = {};
+    out.write(padding, (std::streamsize) ((8 - offset % 8) % 8));
+    out.write(reinterpret_cast<const char*>(columns.data()), (std::streamsize) (columns.size() * sizeof(double)));
+    return out.good();
+}
+
+static bool writeSummary(const fs::path &path, const std::vector<Instance> &instances) {
+    std::ofstream out(path);
+    out << "run,instances,log_error_mean,log_error_max,robot_controllers_mean,freq_count,freq_mean,freq_std,freq_min,"
+           "freq_max,data_rows\n";
+    for (std::size_t i = 0; i < instances.size();) {
+        const int run = instances[i].run;
+        Stats errors, robot_controllers, freq;
+        uint64_t data_rows = 0;
+        std::size_t n = 0;
+        for (; i < instances.size() && instances[i].run == run; ++i, ++n) {
+            errors.add((double) instances[i].log_error);
+            robot_controllers.add((double) instances[i].robot_controllers);
+            freq.merge(instances[i].freq);
+            data_rows += instances[i].data_rows;
+        }
+        out << run << ',' << n << ',' << errors.mean << ',' << errors.max << ',' << robot_controllers.mean << ','
+            << freq.n << ',' << freq.meanOrNan() << ',' << freq.stddev() << ',' << freq.min << ',' << freq.max << ','
+            << data_rows << '\n';
+    }
+    return out.good();
+}
+
+int main(int argc, char **argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    fs::path output = ".";
+    std::vector<fs::path> roots;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = (unsigned) std::max(1, atoi(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg[0] == '-') {
+            std::cerr << "Usage: " << argv[0] << " [-j threads] [-o output dir] [jobfiles or Run_* dir ...]" << '\n';
+            return 2;
+        } else {
+            roots.push_back(arg);
+        }
+    }
+    if (roots.empty()) {
+        roots.push_back("jobfiles");
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Instance> instances;
+    for (const fs::path &root : roots) {
+        if (startsWith(root.filename().string(), "Run_")) {
+            findInstances(root, instances);
+            continue;
+        }
+        std::error_code ec;
+        for (const fs::directory_entry &entry : fs::directory_iterator(root, ec)) {
+            if (entry.is_directory() && startsWith(entry.path().filename().string(), "Run_")) {
+                findInstances(entry.path(), instances);
+            }
+        }
+        if (ec) {
+            std::cerr << "Unable to read " << root << ": " << ec.message() << '\n';
+        }
+    }
+    std::sort(instances.begin(), instances.end(), [](const Instance &a, const Instance &b) {
+        return a.run != b.run ? a.run < b.run : a.instance < b.instance;
+    });
+
+    // Instances are independent; workers take the next one until none is left
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < std::min<std::size_t>(threads, instances.size()); ++t) {
+        workers.emplace_back([&] {
+            for (std::size_t i = next++; i < instances.size(); i = next++) {
+                aggregate(instances[i]);
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    uint64_t bytes = 0;
+    for (const Instance &r : instances) {
+        bytes += r.bytes;
+    }
+    fs::create_directories(output);
+    bool ok = writeColumns(output / "results.rbcol", instances) && writeSummary(output / "run_summary.csv", instances);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Aggregated " << instances.size() << " instances (" << bytes / 1e6 << " MB) with " << workers.size()
+              << " threads in " << wall << " s" << '\n';
+    if (!ok) {
+        std::cerr << "Unable to write the results to " << output << '\n';
+    }
+    return ok ? 0 : 1;
+}
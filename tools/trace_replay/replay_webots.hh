@@ -0,0 +1,273 @@
+#ifndef INCLUDED_REPLAY_WEBOTS_HH_
+#define INCLUDED_REPLAY_WEBOTS_HH_
+
+// Stand-ins for the part of the Webots C++ API used by the inspection
+// controller. Sensors return the values of a recorded trace (trace.hh) and
+// the actuator commands are compared with the recorded ones on every step,
+// so Algorithm1 runs unchanged without a simulator.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "trace.hh"
+
+namespace webots {
+
+struct ReplayState {
+    TraceReader *reader = nullptr;
+    TraceFrame frame;
+    bool started = false;
+    std::size_t next_packet = 0;
+
+    // Commands issued by the controller since the last step
+    double motor[2] = {0, 0};
+    std::vector<TracePacket> sent;
+    std::size_t n_sent = 0;
+    std::string custom_data;
+
+    uint64_t steps = 0;
+    uint64_t mismatches = 0;
+
+    int advance(int duration);
+    void compareOutputs();
+    void mismatch(const char *what, double recorded, double replayed);
+    void reset(TraceReader *trace);
+};
+
+inline ReplayState replay;
+
+inline void ReplayState::reset(TraceReader *trace) {
+    reader = trace;
+    started = false;
+    next_packet = 0;
+    motor[0] = motor[1] = 0;
+    n_sent = 0;
+    custom_data.clear();
+    steps = 0;
+    mismatches = 0;
+}
+
+inline void ReplayState::mismatch(const char *what, double recorded, double replayed) {
+    if (++mismatches <= 10) {
+        std::cerr << "MISMATCH step " << steps << " t=" << frame.time << ": " << what
+                  << " recorded " << recorded << ", replayed " << replayed << '\n';
+    }
+}
+
+inline void ReplayState::compareOutputs() {
+    if (motor[0] != frame.motor_left) {
+        mismatch("left motor velocity", frame.motor_left, motor[0]);
+    }
+    if (motor[1] != frame.motor_right) {
+        mismatch("right motor velocity", frame.motor_right, motor[1]);
+    }
+    if (n_sent != frame.n_sent) {
+        mismatch("packets sent", (double) frame.n_sent, (double) n_sent);
+    } else {
+        for (std::size_t i = 0; i < n_sent; ++i) {
+            if (sent[i].data != frame.sent[i].data) {
+                mismatch("packet content, index", (double) i, (double) i);
+            }
+        }
+    }
+    n_sent = 0;
+}
+
+inline int ReplayState::advance(int duration) {
+    if (started) {
+        compareOutputs();
+    }
+    if (reader == nullptr || !reader->next(frame)) {
+        return -1;
+    }
+    started = true;
+    next_packet = 0;
+    ++steps;
+    if ((int) frame.duration != duration) {
+        mismatch("step duration", frame.duration, duration);
+    }
+    return 0;
+}
+
+
+class Device {
+public:
+    void enable(int) {}
+    void disable() {}
+};
+
+class DistanceSensor : public Device {
+public:
+    explicit DistanceSensor(int index) : index(index) {}
+    double getValue() const { return replay.frame.distance[index]; }
+
+private:
+    int index;
+};
+
+class Gyro : public Device {
+public:
+    const double *getValues() const { return replay.frame.gyro; }
+};
+
+class Accelerometer : public Device {
+public:
+    const double *getValues() const { return replay.frame.accel; }
+};
+
+class Motor : public Device {
+public:
+    explicit Motor(int index) : index(index) {}
+    void setPosition(double) {}
+    void setVelocity(double vel) { replay.motor[index] = vel; }
+    double getVelocity() const { return replay.motor[index]; }
+    double getMaxTorque() const { return 0; }
+
+private:
+    int index;
+};
+
+class Emitter : public Device {
+public:
+    int send(const void *data, int size) {
+        TraceFrame::addPacket(replay.sent, replay.n_sent, data, size);
+        return 1;
+    }
+};
+
+class Receiver : public Device {
+public:
+    int getQueueLength() const { return (int) (replay.frame.n_received - replay.next_packet); }
+    const void *getData() const { return replay.frame.received[replay.next_packet].data.data(); }
+    int getDataSize() const { return (int) replay.frame.received[replay.next_packet].data.size(); }
+    void nextPacket() { ++replay.next_packet; }
+};
+
+class Field {
+public:
+    enum Kind { TRANSLATION, NEIGHBOUR_TRANSLATION, CUSTOM_DATA, OTHER };
+    explicit Field(Kind kind) : kind(kind) {}
+
+    void enableSFTracking(int) {}
+    const double *getSFVec3f() const;
+    void setSFString(const std::string &value);
+    std::string getSFString() const { return kind == CUSTOM_DATA ? replay.custom_data : std::string(); }
+
+private:
+    Kind kind;
+};
+
+// The other robots are not in the trace, only the distance to the nearest
+// one: a single neighbour stands in for them at that distance along x.
+inline const double *Field::getSFVec3f() const {
+    static const double zero[3] = {0, 0, 0};
+    static double neighbour[3];
+    if (kind != TRANSLATION && kind != NEIGHBOUR_TRANSLATION) {
+        return zero;
+    }
+    const double *pose = replay.started ? replay.frame.pose : replay.reader->header.initial_pose;
+    if (kind == TRANSLATION) {
+        return pose;
+    }
+    neighbour[0] = pose[0] + (replay.started ? replay.frame.nearest : replay.reader->header.initial_nearest);
+    neighbour[1] = pose[1];
+    neighbour[2] = pose[2];
+    return neighbour;
+}
+
+inline void Field::setSFString(const std::string &value) {
+    if (kind == CUSTOM_DATA) {
+        replay.custom_data = value;
+    }
+}
+
+class Node {
+public:
+    explicit Node(Field::Kind translationKind = Field::TRANSLATION) : translation(translationKind) {}
+
+    Field *getField(const std::string &name) {
+        if (name == "translation") {
+            return &translation;
+        }
+        if (name == "customData") {
+            return &customData;
+        }
+        return &other;
+    }
+
+private:
+    Field translation;
+    Field customData{Field::CUSTOM_DATA};
+    Field other{Field::OTHER};
+};
+
+class Robot {
+public:
+    virtual ~Robot() {}
+
+    virtual int step(int duration) { return replay.advance(duration); }
+    double getTime() const { return replay.started ? replay.frame.time : 0.0; }
+    std::string getName() const { return replay.reader->header.name; }
+
+    DistanceSensor *getDistanceSensor(const std::string &name);
+    Motor *getMotor(const std::string &name) { return name == "left motor" ? &leftMotor : &rightMotor; }
+    Gyro *getGyro(const std::string &) { return &gyro; }
+    Accelerometer *getAccelerometer(const std::string &) { return &accelerometer; }
+    Emitter *getEmitter(const std::string &) { return &emitter; }
+    Receiver *getReceiver(const std::string &) { return &receiver; }
+
+private:
+    std::vector<DistanceSensor> distanceSensors;
+    Motor leftMotor{0};
+    Motor rightMotor{1};
+    Gyro gyro;
+    Accelerometer accelerometer;
+    Emitter emitter;
+    Receiver receiver;
+};
+
+inline DistanceSensor *Robot::getDistanceSensor(const std::string &name) {
+    const std::vector<std::string> &names = replay.reader->header.sensor_names;
+    if (distanceSensors.empty()) {
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            distanceSensors.emplace_back((int) i);
+        }
+    }
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return &distanceSensors[i];
+        }
+    }
+    std::cerr << "Distance sensor " << name << " is not in the trace" << '\n';
+    return nullptr;
+}
+
+class Supervisor : public Robot {
+public:
+    Node *getSelf() { return &self; }
+    Node *getFromDef(const std::string &name);
+
+private:
+    Node self;
+    Node neighbour{Field::NEIGHBOUR_TRANSLATION};
+};
+
+// The robot itself and its stand-in neighbour, r0 (r1 for robot r0)
+inline Node *Supervisor::getFromDef(const std::string &name) {
+    const std::string &own = replay.reader->header.name;
+    if (name == own) {
+        return &self;
+    }
+    if (name == (own == "r0" ? "r1" : "r0")) {
+        return &neighbour;
+    }
+    return nullptr;
+}
+
+} // namespace webots
+
+#endif // INCLUDED_REPLAY_WEBOTS_HH_
@@ -0,0 +1,2 @@
+// Synthetic stand-in for the Webots Accelerometer API, see ../../synthetic_webots.hh
+#include "../../synthetic_webots.hh"
@@ -0,0 +1,2 @@
+// Synthetic stand-in for the Webots Motor API, see ../../synthetic_webots.hh
+#include "../../synthetic_webots.hh"
@@ -0,0 +1,268 @@
+#ifndef INCLUDED_SYNTHETIC_WEBOTS_HH_
+#define INCLUDED_SYNTHETIC_WEBOTS_HH_
+
+// Deterministic stand-in world for the part of the Webots C++ API used by the
+// inspection controller, used by trace_record to record the sample traces
+// without a simulator. Robot r1 drives on a 1 m x 1 m floor surrounded by
+// walls, next to robot r0 parked at a fixed spot:
+//
+//   - differential drive kinematics from the wheel velocities, integrated
+//     every BASIC_TIME_STEP ms, so one long step() moves the robot exactly
+//     like the same number of single steps
+//   - distance sensors cast rays against the walls and r0 with the geometry
+//     and lookup table of protos/RovableV2.proto (0 .. 150 mm)
+//   - the gyro returns the yaw rate, the accelerometer gravity plus a 7 Hz
+//     floor vibration and deterministic noise
+//   - r1 is moved to another spot when its centre comes within
+//     RELOCATE_DISTANCE of r0, as cpp_supervisor does
+//
+// Nothing here is meant to be physically accurate, only reproducible: the
+// same controller always records the same trace.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "world_rules.hh"
+
+namespace webots {
+
+struct SyntheticWorld {
+    static const int BASIC_TIME_STEP = 20;           // ms
+    static constexpr double WHEEL_RADIUS = 0.0055;   // m
+    static constexpr double AXLE = 0.026;            // m
+    static constexpr double ROBOT_RADIUS = 0.015;    // m
+    static constexpr double SENSOR_OFFSET = 0.008;   // m ahead of the centre
+    static constexpr double SENSOR_RANGE = 0.15;     // m, reads 150
+    static constexpr double SENSOR_ANGLE = 0.47124;  // rad, side sensors
+
+    std::string name = "r1";
+    uint64_t max_steps = 1000;   // step() returns -1 after this many calls
+
+    uint64_t steps = 0;
+    double time = 0;
+    double pose[3] = {0.5, 0.0125, 0.5};
+    double heading = 0;          // rad, 0 along +x
+    double neighbour[3] = {0.65, 0.0125, 0.51};
+    double motor[2] = {0, 0};    // rad/s, left and right
+    double gyro[3] = {};
+    double accel[3] = {};
+    double distance[3] = {150, 150, 150};  // left, right, middle, mm
+    uint32_t noise_state = 12345;
+    uint32_t relocations = 0;
+
+    int advance(int duration);
+    void move(double dt);
+    void sense();
+    double noise();
+    double castRay(double angle) const;
+};
+
+inline SyntheticWorld world;
+
+// Uniform in [-1, 1), from a fixed linear congruential generator
+inline double SyntheticWorld::noise() {
+    noise_state = noise_state * 1664525u + 1013904223u;
+    return (noise_state >> 8) / 8388608.0 - 1.0;
+}
+
+inline void SyntheticWorld::move(double dt) {
+    const double v = 0.5 * (motor[0] + motor[1]) * WHEEL_RADIUS;
+    const double w = (motor[1] - motor[0]) * WHEEL_RADIUS / AXLE;
+    heading += w * dt;
+    pose[0] += v * std::cos(heading) * dt;
+    pose[2] += v * std::sin(heading) * dt;
+    // The walls stop the robot
+    pose[0] = std::clamp(pose[0], ROBOT_RADIUS, 1 - ROBOT_RADIUS);
+    pose[2] = std::clamp(pose[2], ROBOT_RADIUS, 1 - ROBOT_RADIUS);
+    gyro[2] = w;
+
+    if (std::hypot(pose[0] - neighbour[0], pose[2] - neighbour[2]) < RELOCATE_DISTANCE) {
+        ++relocations;
+        pose[0] = 0.2 + 0.6 * (0.5 + 0.5 * noise());
+        pose[2] = 0.2 + 0.6 * (0.5 + 0.5 * noise());
+    }
+}
+
+// Distance in m from the sensor at angle (relative to the heading) to the
+// first wall or robot along its ray, SENSOR_RANGE if nothing is in range
+inline double SyntheticWorld::castRay(double angle) const {
+    const double sx = pose[0] + SENSOR_OFFSET * std::cos(heading);
+    const double sz = pose[2] + SENSOR_OFFSET * std::sin(heading);
+    const double dx = std::cos(heading + angle);
+    const double dz = std::sin(heading + angle);
+    double hit = SENSOR_RANGE;
+    if (dx > 0) hit = std::min(hit, (1 - sx) / dx);
+    if (dx < 0) hit = std::min(hit, -sx / dx);
+    if (dz > 0) hit = std::min(hit, (1 - sz) / dz);
+    if (dz < 0) hit = std::min(hit, -sz / dz);
+
+    const double cx = neighbour[0] - sx;
+    const double cz = neighbour[2] - sz;
+    const double along = cx * dx + cz * dz;
+    const double across2 = cx * cx + cz * cz - along * along;
+    if (along > 0 && across2 < ROBOT_RADIUS * ROBOT_RADIUS) {
+        hit = std::min(hit, along - std::sqrt(ROBOT_RADIUS * ROBOT_RADIUS - across2));
+    }
+    return std::max(hit, 0.0);
+}
+
+inline void SyntheticWorld::sense() {
+    distance[0] = 1000 * castRay(SENSOR_ANGLE);
+    distance[1] = 1000 * castRay(-SENSOR_ANGLE);
+    distance[2] = 1000 * castRay(0);
+    accel[0] = 0.01 * noise();
+    accel[1] = 0.01 * noise();
+    accel[2] = 9.81 + 0.2 * std::sin(2 * M_PI * 7.0 * time) + 0.05 * noise();
+}
+
+inline int SyntheticWorld::advance(int duration) {
+    if (++steps > max_steps) {
+        return -1;
+    }
+    for (int t = 0; t < duration; t += BASIC_TIME_STEP) {
+        move(BASIC_TIME_STEP / 1000.0);
+        time += BASIC_TIME_STEP / 1000.0;
+    }
+    sense();
+    return 0;
+}
+
+
+class Device {
+public:
+    void enable(int) {}
+    void disable() {}
+};
+
+class DistanceSensor : public Device {
+public:
+    explicit DistanceSensor(int index) : index(index) {}
+    double getValue() const { return world.distance[index]; }
+
+private:
+    int index;
+};
+
+class Gyro : public Device {
+public:
+    const double *getValues() const { return world.gyro; }
+};
+
+class Accelerometer : public Device {
+public:
+    const double *getValues() const { return world.accel; }
+};
+
+class Motor : public Device {
+public:
+    explicit Motor(int index) : index(index) {}
+    void setPosition(double) {}
+    void setVelocity(double vel) { world.motor[index] = vel; }
+    double getVelocity() const { return world.motor[index]; }
+    double getMaxTorque() const { return 0; }
+
+private:
+    int index;
+};
+
+class Emitter : public Device {
+public:
+    int send(const void *, int) { return 1; }
+};
+
+class Receiver : public Device {
+public:
+    int getQueueLength() const { return 0; }
+    const void *getData() const { return nullptr; }
+    int getDataSize() const { return 0; }
+    void nextPacket() {}
+};
+
+class Field {
+public:
+    explicit Field(const double *position = nullptr) : position(position) {}
+
+    void enableSFTracking(int) {}
+    const double *getSFVec3f() const;
+    void setSFString(const std::string &value) { text = value; }
+    std::string getSFString() const { return text; }
+
+private:
+    const double *position;
+    std::string text;
+};
+
+inline const double *Field::getSFVec3f() const {
+    static const double zero[3] = {0, 0, 0};
+    return position != nullptr ? position : zero;
+}
+
+class Node {
+public:
+    explicit Node(const double *position) : translation(position) {}
+
+    Field *getField(const std::string &name) {
+        if (name == "translation") {
+            return &translation;
+        }
+        return name == "customData" ? &customData : &other;
+    }
+
+private:
+    Field translation;
+    Field customData;
+    Field other;
+};
+
+class Robot {
+public:
+    virtual ~Robot() {}
+
+    virtual int step(int duration) { return world.advance(duration); }
+    double getTime() const { return world.time; }
+    std::string getName() const { return world.name; }
+
+    DistanceSensor *getDistanceSensor(const std::string &name);
+    Motor *getMotor(const std::string &name) { return name == "left motor" ? &leftMotor : &rightMotor; }
+    Gyro *getGyro(const std::string &) { return &gyro; }
+    Accelerometer *getAccelerometer(const std::string &) { return &accelerometer; }
+    Emitter *getEmitter(const std::string &) { return &emitter; }
+    Receiver *getReceiver(const std::string &) { return &receiver; }
+
+private:
+    DistanceSensor distanceSensors[3] = {DistanceSensor(0), DistanceSensor(1), DistanceSensor(2)};
+    Motor leftMotor{0};
+    Motor rightMotor{1};
+    Gyro gyro;
+    Accelerometer accelerometer;
+    Emitter emitter;
+    Receiver receiver;
+};
+
+inline DistanceSensor *Robot::getDistanceSensor(const std::string &name) {
+    if (name == "left distance sensor") {
+        return &distanceSensors[0];
+    }
+    return name == "right distance sensor" ? &distanceSensors[1] : &distanceSensors[2];
+}
+
+class Supervisor : public Robot {
+public:
+    Node *getSelf() { return &self; }
+    Node *getFromDef(const std::string &name) {
+        if (name == world.name) {
+            return &self;
+        }
+        return name == "r0" ? &neighbour : nullptr;
+    }
+
+private:
+    Node self{world.pose};
+    Node neighbour{world.neighbour};
+};
+
+} // namespace webots
+
+#endif // INCLUDED_SYNTHETIC_WEBOTS_HH_
@@ -0,0 +1,35 @@
+// File:          trace_record.cpp
+// Description:   Runs an unchanged Algorithm1 in the synthetic world of
+//                synthetic_webots.hh and records its trace, so the sample
+//                traces replayed by `make check` can be regenerated from the
+//                tree (`make record`).
+//
+// Usage:         ./trace_record <output dir> [steps]
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "synthetic_webots.hh"
+#include "Algorithm_Template.hh"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <output dir> [steps]" << '\n';
+        return 2;
+    }
+    setenv("RUGBOT_TRACE", argv[1], 1);
+    webots::world.max_steps = argc > 2 ? std::max(1, atoi(argv[2])) : 1000;
+    {
+        Algorithm1 algo;
+        algo.run();
+    }
+    const std::string path = std::string(argv[1]) + "/trace_" + webots::world.name + ".bin";
+    if (!std::ifstream(path)) {
+        return 1;
+    }
+    std::cout << "Recorded " << webots::world.max_steps << " steps (" << webots::world.time << " s simulated, "
+              << webots::world.relocations << " relocations) to " << path << '\n';
+    return 0;
+}
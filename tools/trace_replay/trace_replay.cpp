@@ -0,0 +1,54 @@
+// File:          trace_replay.cpp
+// Description:   Replays a sensor trace recorded by the inspection controller
+//                (RUGBOT_TRACE=<dir>) through an unchanged Algorithm1 without
+//                Webots, and checks that the motor commands and radio packets
+//                match the recording. Runs as fast as the CPU allows.
+//
+// Usage:         ./trace_replay <trace_rX.bin> [repeats]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "replay_webots.hh"
+#include "Algorithm_Template.hh"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [repeats]" << '\n';
+        return 2;
+    }
+    const std::string path = argv[1];
+    const int repeats = argc > 2 ? std::max(1, atoi(argv[2])) : 1;
+
+    // Never record while replaying
+    unsetenv("RUGBOT_TRACE");
+
+    uint64_t mismatches = 0;
+    uint64_t steps = 0;
+    double sim_time = 0;
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < repeats; ++r) {
+        TraceReader reader(path);
+        if (!reader.isOpen()) {
+            std::cerr << "Unable to read trace " << path << '\n';
+            return 2;
+        }
+        webots::replay.reset(&reader);
+        {
+            Algorithm1 algo;
+            algo.run();
+        }
+        mismatches += webots::replay.mismatches;
+        steps += webots::replay.steps;
+        sim_time += webots::replay.frame.time;
+    }
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Replayed " << steps << " steps (" << sim_time << " s simulated) in " << wall << " s, "
+              << (wall > 0 ? sim_time / wall : 0) << "x real time" << '\n';
+    std::cout << mismatches << " mismatches with the recorded actuator commands" << '\n';
+    return mismatches == 0 ? 0 : 1;
+}
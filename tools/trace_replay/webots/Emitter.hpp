@@ -0,0 +1,2 @@
+// Replay stand-in for the Webots Emitter API, see ../replay_webots.hh
+#include "../replay_webots.hh"